@@ -40,6 +40,9 @@ public:
 
 	bool ** delivering;
 	uint32_t next_tid;
+#if MGL_ENABLE
+	MGLock * stock_mgl; // one per warehouse, indexed by w_id - 1
+#endif
 #if CC_ALG == IC3
 	void init_scgraph();
 	SC_PIECE * get_cedges(TPCCTxnType txn_type, int piece_id);
@@ -94,8 +97,12 @@ private:
 #endif
 
 #if CC_ALG == QCC
-    struct qcc_txn *qcc_prepare_payment(const tpcc_query *const query);
-    struct qcc_txn *qcc_prepare_new_order(const tpcc_query *const query);
+    bool qcc_prepare_payment(const tpcc_query *const query);
+    bool qcc_prepare_new_order(const tpcc_query *const query);
+#endif
+
+#if INDEX_PIPELINE
+    void pf_order_lines(tpcc_query * query, uint32_t n);
 #endif
 
 	bool has_local_row(row_t * location, access_t type, row_t * local, access_t local_type) {
@@ -22,6 +22,10 @@
 #define ROW_OFFSET_NEWORDER      0x2a31d33d5035
 #define ROW_OFFSET_ORDERLINE     0xffb25eff04af
 
+// the prepare phase resolves the rows of the rw set into row_buffer[], in
+// query order, and the execution reuses them
+#define TPCC_PREPARED (CC_ALG == QCC || CC_ALG == ORDERED_LOCK || CC_ALG == BASIC_SCHED)
+
 #define RETIRE_ROW(row_cnt) { \
   access_cnt = row_cnt - 1; \
   if (retire_row(access_cnt) == Abort) \
@@ -35,8 +39,12 @@ void tpcc_txn_man::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
 
 
 #if CC_ALG == ORDERED_LOCK
+// table part of the lock ranks
+enum {OL_WAREHOUSE, OL_DISTRICT, OL_CUSTOMER, OL_ITEM, OL_STOCK};
+
 void tpcc_txn_man::ol_prepare_payment(const tpcc_query *const query)
 {
+    const u64 prepare_start = get_sys_clock();
     const u64 q_w_id = query->w_id;
     const u64 q_d_id = query->d_id;
     const bool q_by_last_name = query->by_last_name;
@@ -49,18 +57,21 @@ void tpcc_txn_man::ol_prepare_payment(const tpcc_query *const query)
         rows[0].type = RD;
     }
     const u64 part_id = wh_to_part(q_w_id);
+    rows[0].rank = OL_RANK(OL_WAREHOUSE, q_w_id);
     rows[0].row_item = index_read(_wl->i_warehouse, q_w_id, part_id);
 
     // district
     const u64 d_id = distKey(q_d_id, q_w_id);
     rows[1].type = WR;
+    rows[1].rank = OL_RANK(OL_DISTRICT, d_id);
     rows[1].row_item = index_read(_wl->i_district, d_id, part_id);
 
     // customers
     if (!q_by_last_name) {
         const u64 c_id = custKey(query->c_id, query->c_d_id, query->c_w_id);
         rows[2].type = WR;
-        rows[2].row_item = index_read(_wl->i_customer_id, c_id, part_id);
+        rows[2].rank = OL_RANK(OL_CUSTOMER, c_id);
+        rows[2].row_item = index_read(_wl->i_customer_id, c_id, wh_to_part(query->c_w_id));
     } else {
         // XXX: here is the reconnaissance query. Separate code on calculating the cost may go here.
         const u64 key = custNPKey(query->c_last, query->c_d_id, query->c_w_id);
@@ -82,19 +93,21 @@ void tpcc_txn_man::ol_prepare_payment(const tpcc_query *const query)
         assert(c_id != UINT32_MAX);
         // verified working on correct customer row
         rows[2].type = WR;
+        rows[2].rank = OL_RANK(OL_CUSTOMER, custKey((u64)c_id, query->c_d_id, query->c_w_id));
         rows[2].row_item = mid;
     }
     assert(rows[2].row_item);
 
-    ol_sort_rows();
     for (u64 i=0; i<nr_rows; i++) {
-        // lock, or wait
-        ((row_t *)(rows[i].row_item->location))->manager->lock(rows[i].type);
+        row_buffer[i] = rows[i].row_item;
     }
+    INC_STATS(get_thd_id(), time_prepare, get_sys_clock() - prepare_start);
+    ol_lock_rows();
 }
 
 bool tpcc_txn_man::ol_prepare_new_order(const tpcc_query *const query)
 {
+    const u64 prepare_start = get_sys_clock();
     nr_rows = 0;
 
     const u64 q_w_id = query->w_id;
@@ -116,6 +129,7 @@ bool tpcc_txn_man::ol_prepare_new_order(const tpcc_query *const query)
 
     // 1. warehouse
     rows[nr_rows].type = RD;
+    rows[nr_rows].rank = OL_RANK(OL_WAREHOUSE, q_w_id);
     rows[nr_rows].row_item = index_read(_wl->i_warehouse, q_w_id, wh_to_part(q_w_id));
     assert(rows[nr_rows].row_item);
     nr_rows++;
@@ -123,6 +137,7 @@ bool tpcc_txn_man::ol_prepare_new_order(const tpcc_query *const query)
     // 2. district
     key = distKey(q_d_id, q_w_id);
     rows[nr_rows].type = WR;
+    rows[nr_rows].rank = OL_RANK(OL_DISTRICT, key);
     rows[nr_rows].row_item = index_read(_wl->i_district, key, wh_to_part(q_w_id));
     assert(rows[nr_rows].row_item);
     nr_rows++;
@@ -130,6 +145,7 @@ bool tpcc_txn_man::ol_prepare_new_order(const tpcc_query *const query)
     // 3. customer
     key = custKey(q_c_id, q_d_id, q_w_id);
     rows[nr_rows].type = RD;
+    rows[nr_rows].rank = OL_RANK(OL_CUSTOMER, key);
     rows[nr_rows].row_item = index_read(_wl->i_customer_id, key, wh_to_part(q_w_id));
     assert(rows[nr_rows].row_item);
     nr_rows++;
@@ -144,6 +160,7 @@ bool tpcc_txn_man::ol_prepare_new_order(const tpcc_query *const query)
 #endif
         key = ol_i_id;
         rows[nr_rows].type = RD;
+        rows[nr_rows].rank = OL_RANK(OL_ITEM, key);
         rows[nr_rows].row_item = index_read(_wl->i_item, key, 0);
         assert(rows[nr_rows].row_item);
         nr_rows++;
@@ -153,16 +170,17 @@ bool tpcc_txn_man::ol_prepare_new_order(const tpcc_query *const query)
         const u64 ol_supply_w_id = query->items[ol_number].ol_supply_w_id;
         key = stockKey(ol_i_id, ol_supply_w_id);
         rows[nr_rows].type = WR;
+        rows[nr_rows].rank = OL_RANK(OL_STOCK, key);
         rows[nr_rows].row_item = index_read(_wl->i_stock, key, wh_to_part(ol_supply_w_id));
         assert(rows[nr_rows].row_item);
         nr_rows++;
     }
 
-    ol_sort_rows();
     for (u64 i=0; i<nr_rows; i++) {
-        // lock, or wait
-        ((row_t *)(rows[i].row_item->location))->manager->lock(rows[i].type);
+        row_buffer[i] = rows[i].row_item;
     }
+    INC_STATS(get_thd_id(), time_prepare, get_sys_clock() - prepare_start);
+    ol_lock_rows();
 
     return true;
 }
@@ -170,17 +188,14 @@ bool tpcc_txn_man::ol_prepare_new_order(const tpcc_query *const query)
 // just reuse the code, this is a research project...
 void tpcc_txn_man::ol_finish_tpcc()
 {
-    for (u64 i=nr_rows; i>0; i--) {
-        // lock, or wait
-        ((row_t *)(rows[i-1].row_item->location))->manager->unlock(rows[i-1].type);
-    }
-    nr_rows = 0;
+    ol_unlock_rows();
 }
 #endif
 
 #if CC_ALG == BASIC_SCHED
 void tpcc_txn_man::bs_prepare_payment(const tpcc_query *const query)
 {
+    const u64 prepare_start = get_sys_clock();
     const u64 q_w_id = query->w_id;
     const u64 q_d_id = query->d_id;
     const bool q_by_last_name = query->by_last_name;
@@ -195,17 +210,22 @@ void tpcc_txn_man::bs_prepare_payment(const tpcc_query *const query)
     }
     request.requests[0].id = q_w_id + ROW_OFFSET_WAREHOUSE;
     const u64 part_id = wh_to_part(q_w_id);
+    row_buffer[0] = index_read(_wl->i_warehouse, q_w_id, part_id);
+    assert(row_buffer[0]);
 
     // district
     const u64 d_id = distKey(q_d_id, q_w_id);
     request.requests[1].type = WR;
     request.requests[1].id = d_id + ROW_OFFSET_DISTRICT;
+    row_buffer[1] = index_read(_wl->i_district, d_id, part_id);
+    assert(row_buffer[1]);
 
     // customers
     if (!q_by_last_name) {
         const u64 c_id = custKey(query->c_id, query->c_d_id, query->c_w_id);
         request.requests[2].type = WR;
         request.requests[2].id = c_id + ROW_OFFSET_CUSTOMER;
+        row_buffer[2] = index_read(_wl->i_customer_id, c_id, wh_to_part(query->c_w_id));
     } else {
         // XXX: here is the reconnaissance query. Separate code on calculating the cost may go here.
         const u64 key = custNPKey(query->c_last, query->c_d_id, query->c_w_id);
@@ -228,8 +248,11 @@ void tpcc_txn_man::bs_prepare_payment(const tpcc_query *const query)
         // verified working on correct customer row
         request.requests[2].type = WR;
         request.requests[2].id = c_id + ROW_OFFSET_CUSTOMER;
+        row_buffer[2] = mid;
     }
+    assert(row_buffer[2]);
 
+    INC_STATS(get_thd_id(), time_prepare, get_sys_clock() - prepare_start);
     bs_regulate_request();
     struct basic_sched *const s = this->get_wl()->s;
     basic_sched_request(s, &request);
@@ -238,6 +261,7 @@ void tpcc_txn_man::bs_prepare_payment(const tpcc_query *const query)
 
 bool tpcc_txn_man::bs_prepare_new_order(const tpcc_query *const query)
 {
+    const u64 prepare_start = get_sys_clock();
     request.tid = this->get_thd_id();
     request.nr_requests = 0;
 
@@ -261,18 +285,24 @@ bool tpcc_txn_man::bs_prepare_new_order(const tpcc_query *const query)
     // 1. warehouse
     request.requests[request.nr_requests].type = RD;
     request.requests[request.nr_requests].id = q_w_id + ROW_OFFSET_WAREHOUSE;
+    row_buffer[request.nr_requests] = index_read(_wl->i_warehouse, q_w_id, wh_to_part(q_w_id));
+    assert(row_buffer[request.nr_requests]);
     request.nr_requests++;
 
     // 2. district
     key = distKey(q_d_id, q_w_id);
     request.requests[request.nr_requests].type = WR;
     request.requests[request.nr_requests].id = key + ROW_OFFSET_DISTRICT;
+    row_buffer[request.nr_requests] = index_read(_wl->i_district, key, wh_to_part(q_w_id));
+    assert(row_buffer[request.nr_requests]);
     request.nr_requests++;
 
     // 3. customer
     key = custKey(q_c_id, q_d_id, q_w_id);
     request.requests[request.nr_requests].type = RD;
     request.requests[request.nr_requests].id = key + ROW_OFFSET_CUSTOMER;
+    row_buffer[request.nr_requests] = index_read(_wl->i_customer_id, key, wh_to_part(q_w_id));
+    assert(row_buffer[request.nr_requests]);
     request.nr_requests++;
 
     // 4. stock and item
@@ -286,6 +316,8 @@ bool tpcc_txn_man::bs_prepare_new_order(const tpcc_query *const query)
         key = ol_i_id;
         request.requests[request.nr_requests].type = RD;
         request.requests[request.nr_requests].id = key + ROW_OFFSET_ITEM;
+        row_buffer[request.nr_requests] = index_read(_wl->i_item, key, 0);
+        assert(row_buffer[request.nr_requests]);
         request.nr_requests++;
 
         // only need this with the ol_i_id to read index
@@ -294,9 +326,12 @@ bool tpcc_txn_man::bs_prepare_new_order(const tpcc_query *const query)
         key = stockKey(ol_i_id, ol_supply_w_id);
         request.requests[request.nr_requests].type = WR;
         request.requests[request.nr_requests].id = key + ROW_OFFSET_STOCK;
+        row_buffer[request.nr_requests] = index_read(_wl->i_stock, key, wh_to_part(ol_supply_w_id));
+        assert(row_buffer[request.nr_requests]);
         request.nr_requests++;
     }
 
+    INC_STATS(get_thd_id(), time_prepare, get_sys_clock() - prepare_start);
     bs_regulate_request();
     struct basic_sched *const s = this->get_wl()->s;
     basic_sched_request(s, &request);
@@ -314,10 +349,9 @@ void tpcc_txn_man::bs_finish_tpcc()
 #endif
 
 #if CC_ALG == QCC
-struct qcc_txn *tpcc_txn_man::qcc_prepare_payment(const tpcc_query *const query)
+bool tpcc_txn_man::qcc_prepare_payment(const tpcc_query *const query)
 {
-    struct qcc *const q = this->get_wl()->q;
-    struct qcc_txn *const txn = qcc_txn_acquire(q, this->get_thd_id());
+    const u64 prepare_start = get_sys_clock();
 
     const u64 q_w_id = query->w_id;
     const u64 q_d_id = query->d_id;
@@ -326,7 +360,8 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_payment(const tpcc_query *const query)
     nr_rows = 3;
     // 1. warehouse
     rows[0].rid = q_w_id + ROW_OFFSET_WAREHOUSE;
-    if (g_wh_update) {
+    // w_ytd is merged at commit with COMMUTATIVE_OPS
+    if (g_wh_update && !COMMUTATIVE_OPS) {
         rows[0].type = QCC_TYPE_WR;
     } else {
         rows[0].type = QCC_TYPE_RD;
@@ -334,14 +369,16 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_payment(const tpcc_query *const query)
 
     const u64 part_id = wh_to_part(q_w_id);
 
+    row_part[0] = part_id;
     row_buffer[0] = index_read(_wl->i_warehouse, q_w_id, part_id);
     assert(row_buffer[0]);
 
     // 2. district
     const u64 d_id = distKey(q_d_id, q_w_id);
     rows[1].rid = d_id + ROW_OFFSET_DISTRICT;
-    rows[1].type = QCC_TYPE_WR;
+    rows[1].type = COMMUTATIVE_OPS? QCC_TYPE_RD : QCC_TYPE_WR;
 
+    row_part[1] = part_id;
     row_buffer[1] = index_read(_wl->i_district, d_id, part_id);
     assert(row_buffer[1]);
 
@@ -349,11 +386,13 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_payment(const tpcc_query *const query)
     // this is a special case because two indexes can point to the same customer
     // so for the last_name based search, we need to read the row's id
     // this incurs an extra search in the index, can be optimized
+    // the customer may be in a remote warehouse
+    row_part[2] = wh_to_part(query->c_w_id);
     if (!q_by_last_name) {
         const u64 c_id = custKey(query->c_id, query->c_d_id, query->c_w_id);
         rows[2].rid = c_id + ROW_OFFSET_CUSTOMER;
         rows[2].type = QCC_TYPE_WR;
-        row_buffer[2] = index_read(_wl->i_customer_id, c_id, part_id);
+        row_buffer[2] = index_read(_wl->i_customer_id, c_id, row_part[2]);
     } else {
         // XXX: here is the reconnaissance query. Separate code on calculating the cost may go here.
         const u64 key = custNPKey(query->c_last, query->c_d_id, query->c_w_id);
@@ -380,15 +419,15 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_payment(const tpcc_query *const query)
     }
     assert(row_buffer[2]);
 
-    qcc_txn_enqueue(q, txn, &rows[0], nr_rows, &queues[0], &nr_queues);
+    INC_STATS(get_thd_id(), time_prepare, get_sys_clock() - prepare_start);
+    qcc_enqueue();
 
-    return txn;
+    return true;
 }
 
-struct qcc_txn *tpcc_txn_man::qcc_prepare_new_order(const tpcc_query *const query)
+bool tpcc_txn_man::qcc_prepare_new_order(const tpcc_query *const query)
 {
-    struct qcc *const q = this->get_wl()->q;
-    struct qcc_txn *const txn = qcc_txn_acquire(q, this->get_thd_id());
+    const u64 prepare_start = get_sys_clock();
 
     nr_rows = 0;
 
@@ -403,6 +442,7 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_new_order(const tpcc_query *const quer
     rows[nr_rows].rid = q_w_id + ROW_OFFSET_WAREHOUSE;
     rows[nr_rows].type = QCC_TYPE_RD;
 
+    row_part[nr_rows] = wh_to_part(q_w_id);
     row_buffer[nr_rows] = index_read(_wl->i_warehouse, q_w_id, wh_to_part(q_w_id));
     assert(row_buffer[nr_rows]);
     nr_rows++;
@@ -411,6 +451,7 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_new_order(const tpcc_query *const quer
     key = distKey(q_d_id, q_w_id);
     rows[nr_rows].rid = key + ROW_OFFSET_DISTRICT;
     rows[nr_rows].type = QCC_TYPE_WR;
+    row_part[nr_rows] = wh_to_part(q_w_id);
     row_buffer[nr_rows] = index_read(_wl->i_district, key, wh_to_part(q_w_id));
     assert(row_buffer[nr_rows]);
     nr_rows++;
@@ -419,6 +460,7 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_new_order(const tpcc_query *const quer
     key = custKey(q_c_id, q_d_id, q_w_id);
     rows[nr_rows].rid = key + ROW_OFFSET_CUSTOMER;
     rows[nr_rows].type = QCC_TYPE_RD;
+    row_part[nr_rows] = wh_to_part(q_w_id);
     row_buffer[nr_rows] = index_read(_wl->i_customer_id, key, wh_to_part(q_w_id));
     assert(row_buffer[nr_rows]);
     nr_rows++;
@@ -428,13 +470,15 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_new_order(const tpcc_query *const quer
         const u64 ol_i_id = query->items[ol_number].ol_i_id;
 #if TPCC_USER_ABORT
         if (ol_i_id == 0) {
-            // Note: just return NULL here, and run_txn() will handle the problem
-            return NULL;
+            // Note: just return false here, and run_txn() will handle the problem
+            return false;
         }
 #endif
         key = ol_i_id;
         rows[nr_rows].rid = key + ROW_OFFSET_ITEM;
         rows[nr_rows].type = QCC_TYPE_RD;
+        // items are never written, queue them at home to keep the txn local
+        row_part[nr_rows] = wh_to_part(q_w_id);
         row_buffer[nr_rows] = index_read(_wl->i_item, key, 0);
         assert(row_buffer[nr_rows]);
         nr_rows++;
@@ -445,14 +489,16 @@ struct qcc_txn *tpcc_txn_man::qcc_prepare_new_order(const tpcc_query *const quer
         key = stockKey(ol_i_id, ol_supply_w_id);
         rows[nr_rows].rid = key + ROW_OFFSET_STOCK;
         rows[nr_rows].type = QCC_TYPE_WR;
+        row_part[nr_rows] = wh_to_part(ol_supply_w_id);
         row_buffer[nr_rows] = index_read(_wl->i_stock, key, wh_to_part(ol_supply_w_id));
         assert(row_buffer[nr_rows]);
         nr_rows++;
     }
 
-    qcc_txn_enqueue(q, txn, &rows[0], nr_rows, &queues[0], &nr_queues);
+    INC_STATS(get_thd_id(), time_prepare, get_sys_clock() - prepare_start);
+    qcc_enqueue();
 
-    return txn;
+    return true;
 }
 #endif
 
@@ -460,7 +506,6 @@ RC tpcc_txn_man::run_txn(base_query * query) {
   tpcc_query * m_query = (tpcc_query *) query;
 
 #if CC_ALG == QCC
-    struct qcc *const q = this->get_wl()->q;
     u8 local_clean = 0;
 #endif
 
@@ -469,44 +514,49 @@ RC tpcc_txn_man::run_txn(base_query * query) {
 
     if (type == TPCC_PAYMENT) {
 #if CC_ALG == QCC
-	  struct qcc_txn *const txn = qcc_prepare_payment(m_query);
-      if (!txn) {
+	  const bool good = qcc_prepare_payment(m_query);
+      if (!good) {
           rc = finish(ERROR);
           assert(rc == ERROR);
       } else {
 #if QCC_GENERAL
-          qcc_txn_snapshot(q, txn, &rows[0], nr_rows); // take a snapshot before execution.. whatever
+          qcc_snapshot(); // take a snapshot before execution.. whatever
           rc = run_payment(m_query); // try run once locally
-          qcc_txn_wait(q, txn); // wait until it is my turn to commit
-          if (qcc_txn_snapshot_consistent(q, txn, &rows[0], nr_rows, nr_rows)) {
+          qcc_wait(); // wait until it is my turn to commit
+          if (qcc_snapshot_consistent()) {
               rc = RCOK;
           } else {
               rc = Abort;
           }
           rc = finish(rc);
-          qcc_txn_finish(q, txn, queues, nr_queues);
+          qcc_announce();
 #else
-          while (!qcc_txn_try_wait(q, txn)) {
-              if (local_clean && qcc_txn_snapshot_consistent(q, txn, &rows[0], nr_rows, nr_rows)) {
+          u64 try_cnt = 0;
+          const u64 max_try_cnt = qcc_spec_budget(type, g_thread_cnt / 2 + 1);
+          while (!qcc_try_wait() && try_cnt < max_try_cnt) {
+              if (local_clean && qcc_snapshot_consistent()) {
                 continue;
               }
+              try_cnt++;
               cleanup(Abort);
               local_clean = 0;
-              qcc_txn_snapshot(q, txn, &rows[0], nr_rows);
+              qcc_snapshot();
               rc = run_payment(m_query); // try run once locally
               if (rc == RCOK) {
                   local_clean = 1;
               }
           }
-          qcc_txn_wait(q, txn);
-          if (!local_clean || !qcc_txn_snapshot_consistent(q, txn, &rows[0], nr_rows, nr_rows)) {
+          qcc_wait();
+          if (!local_clean || !qcc_spec_consistent()) {
               cleanup(Abort);
+              qcc_spec_result(type, try_cnt, false);
               rc = run_payment(m_query);
           } else {
+              qcc_spec_result(type, try_cnt, true);
               rc = RCOK;
           }
           rc = finish(rc);
-          qcc_txn_finish(q, txn, queues, nr_queues);
+          qcc_announce();
 #endif
       }
 #elif CC_ALG == ORDERED_LOCK
@@ -524,44 +574,49 @@ RC tpcc_txn_man::run_txn(base_query * query) {
 #endif
     } else if (type == TPCC_NEW_ORDER) {
 #if CC_ALG == QCC
-	  struct qcc_txn *const txn = qcc_prepare_new_order(m_query);
-      if (!txn) {
+	  const bool good = qcc_prepare_new_order(m_query);
+      if (!good) {
           rc = finish(ERROR);
           assert(rc == ERROR);
       } else {
 #if QCC_GENERAL
-          qcc_txn_snapshot(q, txn, &rows[0], nr_rows); // take a snapshot before execution.. whatever
+          qcc_snapshot(); // take a snapshot before execution.. whatever
           rc = run_payment(m_query); // try run once locally
-          qcc_txn_wait(q, txn); // wait until it is my turn to commit
-          if (qcc_txn_snapshot_consistent(q, txn, &rows[0], nr_rows, nr_rows)) {
+          qcc_wait(); // wait until it is my turn to commit
+          if (qcc_snapshot_consistent()) {
               rc = RCOK;
           } else {
               rc = Abort;
           }
           rc = finish(rc);
-          qcc_txn_finish(q, txn, queues, nr_queues);
+          qcc_announce();
 #else
-          while (!qcc_txn_try_wait(q, txn)) {
-              if (local_clean && qcc_txn_snapshot_consistent(q, txn, &rows[0], nr_rows, nr_rows)) {
+          u64 try_cnt = 0;
+          const u64 max_try_cnt = qcc_spec_budget(type, g_thread_cnt / 2 + 1);
+          while (!qcc_try_wait() && try_cnt < max_try_cnt) {
+              if (local_clean && qcc_snapshot_consistent()) {
                 continue;
               }
+              try_cnt++;
               cleanup(Abort);
               local_clean = 0;
-              qcc_txn_snapshot(q, txn, &rows[0], nr_rows);
+              qcc_snapshot();
               rc = run_new_order(m_query); // try run once locally
               if (rc == RCOK) {
                   local_clean = 1;
               }
           }
-          qcc_txn_wait(q, txn);
-          if (!local_clean || !qcc_txn_snapshot_consistent(q, txn, &rows[0], nr_rows, nr_rows)) {
+          qcc_wait();
+          if (!local_clean || !qcc_spec_consistent()) {
               cleanup(Abort);
+              qcc_spec_result(type, try_cnt, false);
               rc = run_new_order(m_query);
           } else {
+              qcc_spec_result(type, try_cnt, true);
               rc = RCOK;
           }
           rc = finish(rc);
-          qcc_txn_finish(q, txn, queues, nr_queues);
+          qcc_announce();
 #endif
       }
 #elif CC_ALG == ORDERED_LOCK
@@ -653,7 +708,7 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
 
   //BEGIN: [WAREHOUSE] RW
   //use index to retrieve that warehouse
-#if CC_ALG == QCC
+#if TPCC_PREPARED
   item = row_buffer[0];
 #else
   key = query->w_id;
@@ -682,7 +737,8 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
     r_wh_local->set_value(W_YTD, tmp_value + query->h_amount);
   }
 #else
-  inc_value(W_YTD, query->h_amount); // will increment at commit time
+  if (g_wh_update)
+    merge_value(W_YTD, COM_ADD, query->h_amount); // applied at commit time
 #endif
   // bamboo: retire lock for wh
 #if (CC_ALG == BAMBOO) && (THREAD_CNT > 1) && !COMMUTATIVE_OPS
@@ -705,7 +761,7 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
       EXEC SQL UPDATE district SET d_ytd = d_ytd + :h_amount
       WHERE d_w_id=:w_id AND d_id=:d_id;
   +=====================================================*/
-#if CC_ALG == QCC
+#if TPCC_PREPARED
   item = row_buffer[1];
 #else
   key = distKey(query->d_id, query->d_w_id);
@@ -729,7 +785,7 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
   r_dist_local->get_value(D_YTD, tmp_value);
   r_dist_local->set_value(D_YTD, tmp_value + query->h_amount);
 #else
-  inc_value(D_YTD, query->h_amount); // will increment at commit time
+  merge_value(D_YTD, COM_ADD, query->h_amount); // applied at commit time
 #endif
 #if (CC_ALG == BAMBOO) && (THREAD_CNT > 1) && !COMMUTATIVE_OPS
   RETIRE_ROW(row_cnt)
@@ -768,12 +824,14 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
     // XXX: the list is not sorted. But let's assume it's sorted...
     // The performance won't be much different.
 
-    // XXX: QCC, BASIC_SCHED, and ORDERED_LOCK still lookup this info
-    // to mock the verification of rw-set queries.
-    // In the current modeling, no index insertion to the customer table is performed
-    // so the verification won't fail. Abort not needed. Panic if anything went wrong then
-    //
-    // The verification can be turned off in experiment, as they won't return Abort
+#if TPCC_PREPARED
+    // resolved by the prepare phase, which had to find the customer to
+    // build the rw set. No customer is ever inserted, so another scan of
+    // i_customer_last cannot find a different row.
+    item = row_buffer[2];
+    assert(item != NULL);
+    r_cust = ((row_t *)item->location);
+#else
     uint64_t key = custNPKey(query->c_last, query->c_d_id, query->c_w_id);
     INDEX * index = _wl->i_customer_last;
     item = index_read(index, key, wh_to_part(c_w_id));
@@ -788,44 +846,6 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
         mid = mid->next;
     }
     //get the center one, as in spec
-#if CC_ALG == QCC
-    item = row_buffer[2];
-    if (item != mid) {
-        printf("QCC error: payment customer changed\n");
-        fflush(stdout);
-        return Abort;
-    }
-    r_cust = ((row_t *)item->location);
-#elif CC_ALG == ORDERED_LOCK
-    u8 found = 0;
-    for (u32 i=0; i<nr_rows; i++) {
-        if (mid == rows[i].row_item) {
-            found = 1;
-        }
-    }
-    if (!found) {
-        printf("ORDERED_LOCK error: payment customer changed\n");
-        fflush(stdout);
-        return Abort;
-    }
-    r_cust = ((row_t *)mid->location);
-#elif CC_ALG == BASIC_SCHED
-    u32 c_id = UINT32_MAX;
-    ((row_t *)(mid->location))->get_value(C_ID, c_id);
-    assert(c_id != UINT32_MAX);
-    u8 found = 0;
-    for (u32 i=0; i<request.nr_requests; i++) {
-        if (((u64)c_id + ROW_OFFSET_CUSTOMER) % BASIC_SCHED_SIZE == request.requests[i].id) {
-            found = 1;
-        }
-    }
-    if (!found) {
-        printf("BASIC_SCHED error: payment customer changed\n");
-        fflush(stdout);
-        return Abort;
-    }
-    r_cust = ((row_t *)mid->location);
-#else
     r_cust = ((row_t *)mid->location);
 #endif
   }
@@ -840,7 +860,7 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
         FROM customer
         WHERE c_w_id=:c_w_id AND c_d_id=:c_d_id AND c_id=:c_id;
     +======================================================================*/
-#if CC_ALG == QCC
+#if TPCC_PREPARED
     item = row_buffer[2];
 #else
     key = custKey(query->c_id, query->c_d_id, query->c_w_id);
@@ -928,6 +948,27 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
 #endif
 }
 
+#if INDEX_PIPELINE
+// [PREFETCH_DEPTH] resolves the order line entries up to entry n, entry
+// 2 * ol_number is the item of the line and entry 2 * ol_number + 1 its stock
+void tpcc_txn_man::pf_order_lines(tpcc_query * query, uint32_t n) {
+  while (pf_cnt < 2 * query->ol_cnt && pf_cnt <= n) {
+    uint64_t ol_i_id = query->items[pf_cnt / 2].ol_i_id;
+    uint64_t ol_supply_w_id = query->items[pf_cnt / 2].ol_supply_w_id;
+#if TPCC_USER_ABORT
+    // not in the index, the txn aborts at this line
+    if (ol_i_id == 0)
+      return;
+#endif
+    if (pf_cnt % 2 == 0)
+      pf_push(index_read(_wl->i_item, ol_i_id, 0));
+    else
+      pf_push(index_read(_wl->i_stock, stockKey(ol_i_id, ol_supply_w_id),
+                         wh_to_part(ol_supply_w_id)));
+  }
+}
+#endif
+
 RC tpcc_txn_man::run_new_order(tpcc_query * query) {
   RC rc = RCOK;
   uint64_t key;
@@ -993,13 +1034,13 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
       WHERE w_id = :w_id AND c_w_id = w_id AND c_d_id = :d_id AND c_id = :c_id;
   +========================================================================*/
 
-#if CC_ALG == QCC
+#if TPCC_PREPARED
   u64 count = 0;
   (void)ol_i_id;
   (void)ol_supply_w_id;
 #endif
 
-#if CC_ALG == QCC
+#if TPCC_PREPARED
   item = row_buffer[count++];
 #else
   key = w_id;
@@ -1025,7 +1066,7 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
   EXEC SQL UPDATE d istrict SET d _next_o_id = :d _next_o_id + 1
       WH ERE d _id = :d_id AN D d _w _id = :w _id ;
   +===================================================*/
-#if CC_ALG == QCC
+#if TPCC_PREPARED
   item = row_buffer[count++];
 #else
   key = distKey(d_id, w_id);
@@ -1055,7 +1096,7 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 #endif
 
   //select customer
-#if CC_ALG == QCC
+#if TPCC_PREPARED
   item = row_buffer[count++];
 #else
   key = custKey(c_id, d_id, w_id);
@@ -1116,6 +1157,9 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 
   // Here for QCC..
 
+#if INDEX_PIPELINE
+  pf_cnt = 0;
+#endif
   for (UInt32 ol_number = 0; ol_number < ol_cnt; ol_number++) {
         ol_i_id = query->items[ol_number].ol_i_id;
 #if TPCC_USER_ABORT
@@ -1136,8 +1180,16 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
             FROM item
             WHERE i_id = :ol_i_id;
         +===========================================*/
-#if CC_ALG == QCC
+#if TPCC_PREPARED
         item = row_buffer[count++];
+#elif INDEX_PIPELINE
+        if (g_prefetch_depth > 0) {
+          pf_order_lines(query, 2 * ol_number + g_prefetch_depth);
+          item = pf_get(2 * ol_number);
+        } else {
+          key = ol_i_id;
+          item = index_read(_wl->i_item, key, 0);
+        }
 #else
         key = ol_i_id;
         item = index_read(_wl->i_item, key, 0);
@@ -1170,8 +1222,17 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
             AND s_w_id = :ol_supply_w_id;
         +===============================================*/
 
-#if CC_ALG == QCC
+#if TPCC_PREPARED
         stock_item = row_buffer[count++];
+#elif INDEX_PIPELINE
+        if (g_prefetch_depth > 0) {
+          pf_order_lines(query, 2 * ol_number + 1 + g_prefetch_depth);
+          stock_item = pf_get(2 * ol_number + 1);
+        } else {
+          stock_key = stockKey(ol_i_id, ol_supply_w_id);
+          stock_index = _wl->i_stock;
+          index_read(stock_index, stock_key, wh_to_part(ol_supply_w_id), stock_item);
+        }
 #else
         stock_key = stockKey(ol_i_id, ol_supply_w_id);
         stock_index = _wl->i_stock;
@@ -1179,7 +1240,12 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 #endif
         assert(stock_item != NULL);
         r_stock = ((row_t *)stock_item->location);
+#if MGL_ENABLE
+        r_stock_local = get_row_mgl(r_stock, WR,
+                                    &_wl->stock_mgl[ol_supply_w_id - 1]);
+#else
         r_stock_local = get_row(r_stock, WR);
+#endif
         if (r_stock_local == NULL) {
 #if CC_ALG == QCC
             return Abort;
@@ -26,6 +26,11 @@ RC tpcc_wl::init() {
 	cout << "TPCC schema initialized" << endl;
 	init_table();
 	next_tid = 0;
+#if MGL_ENABLE
+	stock_mgl = (MGLock *) _mm_malloc(sizeof(MGLock) * num_wh, 64);
+	for (uint32_t i = 0; i < num_wh; i++)
+		stock_mgl[i].init();
+#endif
 	ASSERT(g_perc_neworder >= 0);
 #if CC_ALG == IC3
 	init_scgraph();
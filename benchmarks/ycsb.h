@@ -55,7 +55,7 @@ private:
 #endif
 
 #if CC_ALG == QCC
-    struct qcc_txn *qcc_prepare_ycsb(const ycsb_query *const query);
+    bool qcc_prepare_ycsb(const ycsb_query *const query);
 #endif
 };
 
@@ -122,6 +122,16 @@ void ycsb_query::gen_requests(uint64_t thd_id, workload * h_wl) {
 
 #if SYNTHETIC_YCSB
 uint64_t table_size = g_synth_table_size / g_virtual_part_cnt;
+#if NUM_HS == 1
+	// with a single hotspot, FLIP_RATIO of the txns access it as SECOND_HS
+	access_t hs_type = FIRST_HS;
+	if (g_flip_ratio > 0) {
+		double flip;
+		drand48_r(&_query_thd->buffer, &flip);
+		if (flip < g_flip_ratio)
+			hs_type = SECOND_HS;
+	}
+#endif
 #endif
 	uint64_t rid = 0;
 	uint64_t tmp;
@@ -139,25 +149,25 @@ uint64_t table_size = g_synth_table_size / g_virtual_part_cnt;
 #if POS_HS == TOP
 		if (tmp == 0) {
 			// insert hotpost at the beginning
-			req->rtype = FIRST_HS;
+			req->rtype = hs_type;
 			row_id = table_size - 1;
 		} else {
 #elif POS_HS == MID
 		if (tmp == (g_req_per_query / 2)) {
 			// insert hotpost at the beginning
-			req->rtype = FIRST_HS;
+			req->rtype = hs_type;
 			row_id = table_size - 1;
 		} else {
 #elif POS_HS == BOT
 		if (tmp == (g_req_per_query - 1)) {
 			// insert hotpost at the beginning
-			req->rtype = FIRST_HS;
+			req->rtype = hs_type;
 			row_id = table_size - 1;
 		} else {
 #elif POS_HS == SPECIFIED
 		UInt32 hs_idx = (UInt32) min((int)g_req_per_query-1, max(1, (int) floor(g_req_per_query * g_specified_ratio)));
 		if (tmp == hs_idx) {
-			req->rtype = FIRST_HS;
+			req->rtype = hs_type;
                         row_id = table_size - 1;
 		} else {
 #else
@@ -32,27 +32,18 @@ void ycsb_txn_man::ol_prepare_ycsb(const ycsb_query *const query)
         rows[i].type = req->rtype;
         const u64 key = req->key;
         int part_id = _wl->key_to_part(key);
+        rows[i].rank = OL_RANK(0, key);
         rows[i].row_item = index_read(_wl->the_index, key, part_id);
     }
 
-    // now we have read the index and got all the keys, lets sort them
-    ol_sort_rows();
-
-    // sorted, lock them then
-    for (u64 i=0; i<nr_rows; i++) {
-        // lock, or wait
-        ((row_t *)(rows[i].row_item->location))->manager->lock(rows[i].type);
-    }
+    // now we have read the index and got all the keys, lock them in order
+    ol_lock_rows();
 }
 
 void ycsb_txn_man::ol_finish_ycsb()
 {
     // unlock them
-    for (u64 i=nr_rows; i>0; i--) {
-        // lock, or wait
-        ((row_t *)(rows[i-1].row_item->location))->manager->unlock(rows[i-1].type);
-    }
-    nr_rows = 0;
+    ol_unlock_rows();
 }
 #endif
 
@@ -85,12 +76,8 @@ void ycsb_txn_man::bs_finish_ycsb()
 #endif
 
 #if CC_ALG == QCC
-struct qcc_txn *ycsb_txn_man::qcc_prepare_ycsb(const ycsb_query *const query)
+bool ycsb_txn_man::qcc_prepare_ycsb(const ycsb_query *const query)
 {
-    struct qcc *const q = this->get_wl()->q;
-    struct qcc_txn *const txn = qcc_txn_acquire(q, this->get_thd_id());
-    assert(txn);
-
     nr_rows = query->request_cnt;
 
     for (u64 i=0; i < nr_rows; i++) {
@@ -103,32 +90,32 @@ struct qcc_txn *ycsb_txn_man::qcc_prepare_ycsb(const ycsb_query *const query)
             rows[i].type = QCC_TYPE_WR;
         }
         int part_id = _wl->key_to_part(key);
+        row_part[i] = part_id;
         row_buffer[i] = index_read(_wl->the_index, key, part_id);
         assert(row_buffer[i]);
     }
-    qcc_txn_enqueue(q, txn, &rows[0], nr_rows, &queues[0], &nr_queues);
-    return txn;
+    qcc_enqueue();
+    return true;
     // always return..
 }
 #endif
 
 RC ycsb_txn_man::run_txn(base_query * query) {
 #if CC_ALG == QCC
-    struct qcc *const q = this->get_wl()->q;
     RC rc;
     u8 local_clean = 0;
     u8 try_cnt = 0;
-    const u64 max_try_cnt = q->nr_workers / 2 + 1;
+    const u64 max_try_cnt = qcc_spec_budget(0, g_thread_cnt / 2 + 1);
 
-    struct qcc_txn *const txn = qcc_prepare_ycsb((ycsb_query *)query);
+    const bool good = qcc_prepare_ycsb((ycsb_query *)query);
 
-    if (!txn) {
+    if (!good) {
         // finish() called here!
         rc = finish(Abort);
         assert(rc == Abort);
     } else {
-        while (!qcc_txn_try_wait(q, txn) && try_cnt < max_try_cnt) {
-            if (local_clean && qcc_txn_snapshot_consistent(q, txn, &rows[0], nr_rows, nr_rows)) {
+        while (!qcc_try_wait() && try_cnt < max_try_cnt) {
+            if (local_clean && qcc_snapshot_consistent()) {
                 continue;
             }
             try_cnt++;
@@ -136,27 +123,29 @@ RC ycsb_txn_man::run_txn(base_query * query) {
                 cleanup(Abort); // remove the results in last attempt
             }
             local_clean = 0; // mark local status as dirty
-            qcc_txn_snapshot(q, txn, &rows[0], nr_rows);
+            qcc_snapshot();
             rc = run_txn_r(query); // try run once locally
             if (rc == RCOK) {
                 local_clean = 1;
             }
         }
-        qcc_txn_wait(q, txn); // wait more
-        if (!local_clean || !qcc_txn_snapshot_consistent(q, txn, &rows[0], nr_rows, nr_rows)) {
+        qcc_wait(); // wait more
+        if (!local_clean || !qcc_spec_consistent()) {
             // really execute unless:
             // 1. clean mark is set and
             // 2. the snapshot is consistent wrd last try
             if (try_cnt) {
                 cleanup(Abort);
             }
+            qcc_spec_result(0, try_cnt, false);
             rc = run_txn_r(query); // try run once locally
         } else {
+            qcc_spec_result(0, try_cnt, true);
             assert(rc == RCOK);
         }
         rc = finish(rc);
     }
-    qcc_txn_finish(q, txn, queues, nr_queues); // announce!
+    qcc_announce(); // announce!
     return rc;
 #elif CC_ALG == ORDERED_LOCK
     ol_prepare_ycsb((ycsb_query *)query);
@@ -187,6 +176,9 @@ RC ycsb_txn_man::run_txn_r(base_query * query) {
 #else
     row_cnt = 0;
 #endif
+#if INDEX_PIPELINE
+    pf_cnt = 0;
+#endif
 
     // if long txn and not rerun aborted txn, generate queries
     if (unlikely(m_query->is_long && !(m_query->rerun))) {
@@ -204,6 +196,15 @@ RC ycsb_txn_man::run_txn_r(base_query * query) {
             if (iteration == 0) {
 #if CC_ALG == QCC
                 m_item = row_buffer[rid];
+#elif INDEX_PIPELINE
+                if (g_prefetch_depth > 0) {
+                    while (pf_cnt < m_query->request_cnt && pf_cnt <= rid + g_prefetch_depth) {
+                        idx_key_t key = m_query->requests[pf_cnt].key;
+                        pf_push(index_read(_wl->the_index, key, wl->key_to_part(key)));
+                    }
+                    m_item = pf_get(rid);
+                } else
+                    m_item = index_read(_wl->the_index, req->key, part_id);
 #else
                 m_item = index_read(_wl->the_index, req->key, part_id);
 #endif
@@ -241,12 +242,21 @@ RC ycsb_txn_man::run_txn_r(base_query * query) {
                     assert(req->rtype == WR);
 //					for (int fid = 0; fid < schema->get_field_cnt(); fid++) {
                         int fid = 0;
+#if CC_ALG == QCC
+                        // kept in the redo log until commit
+                        uint64_t fval = 0;
+                        row_local->set_value(fid, &fval, sizeof(fval));
+#else
 #if (CC_ALG == BAMBOO) || (CC_ALG == WOUND_WAIT)
                         char * data = row_local->get_data();
 #else
                         char * data = row->get_data();
 #endif
                         *(uint64_t *)(&data[fid * 10]) = 0;
+#endif
+#if ROW_TRACK_WR_COLS
+                        row_local->mark_written(fid);
+#endif
 //					}
                 }
             }
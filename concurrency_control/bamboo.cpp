@@ -9,6 +9,14 @@
 #if CC_ALG == BAMBOO
 RC
 txn_man::retire_row(int access_cnt){
+#if MGL_ENABLE
+  if (accesses[access_cnt]->mgl)
+    return RCOK;
+#endif
+#if BB_ADAPTIVE_RETIRE
+  if (!accesses[access_cnt]->retire)
+    return RCOK;
+#endif
   return accesses[access_cnt]->orig_row->retire_row(accesses[access_cnt]->lock_entry);
 }
 #endif
@@ -24,3 +32,16 @@ txn_man::increment_commit_barriers() {
     //ATOM_ADD(*addr_barriers, 1UL << 2);
     ATOM_ADD(commit_barriers, 1UL << 2);
 }
+
+bool
+txn_man::try_commit() {
+    // test before CAS so that spinning keeps the line shared with the
+    // dependents decrementing it. barrier_cas_retry only counts a CAS that
+    // lost a race after the word read zero, not the spins waiting for it
+    if (commit_barriers != 0)
+        return false;
+    if (ATOM_CAS(commit_barriers, 0, COMMITED))
+        return true;
+    INC_STATS(get_thd_id(), barrier_cas_retry, 1);
+    return false;
+}
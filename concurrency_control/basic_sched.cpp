@@ -6,6 +6,18 @@ struct basic_sched *basic_sched_create()
 {
     struct basic_sched *const s = (struct basic_sched *)malloc(sizeof(*s));
     memset(s, 0, sizeof(*s));
+    for (u64 i=0; i<THREAD_CNT; i++) {
+        s->worker_meta[i].cursor = BASIC_SCHED_THREADS;
+    }
+    for (u64 k=0; k<BASIC_SCHED_THREADS; k++) {
+        s->shard[k].s = s;
+        s->shard[k].id = k;
+        s->shard[k].status = (struct basic_sched_status *)calloc(BASIC_SCHED_SIZE, sizeof(struct basic_sched_status));
+#if BASIC_SCHED_SHADOW
+        s->shard[k].shadow = (struct basic_sched_status *)calloc(BASIC_SCHED_SIZE, sizeof(struct basic_sched_status));
+#endif
+    }
+    s->valid = 1;
     return s;
 }
 
@@ -27,23 +39,116 @@ struct basic_sched *basic_sched_create()
 //     fflush(stdout);
 // }
 
-static u8 basic_sched_schedule(struct basic_sched *const s, const u64 tid)
+// requests are sorted by hash (see txn_man::bs_regulate_request), return the
+// first one in shard >= k
+static u64 basic_sched_lower_bound(const struct basic_sched_request *const r, const u32 k)
+{
+    u64 lo = 0, hi = r->nr_requests;
+    while (lo < hi) {
+        const u64 mid = (lo + hi) / 2;
+        if (BASIC_SCHED_SHARD(r->requests[mid].hash) < k) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// the slot of key, or the empty slot ending its probe sequence
+static u64 basic_sched_find(const struct basic_sched_status *const table, const u64 key, const u64 hash)
+{
+    u64 i = hash & (BASIC_SCHED_SIZE - 1);
+    while (table[i].used && table[i].key != key) {
+        i = (i + 1) & (BASIC_SCHED_SIZE - 1);
+    }
+    return i;
+}
+
+// free slot i once nobody holds or waits for its key. Backward shift
+// deletion: move up later entries of the cluster whose home slot does not lie
+// in (i, j], so every probe sequence stays unbroken without tombstones
+static void basic_sched_reclaim(struct basic_sched_status *const table, u64 i)
 {
+    if (table[i].nr_readers || table[i].nr_writers || table[i].write_requested || table[i].wait_head) {
+        return;
+    }
+    u64 j = i;
+    while (true) {
+        memset(&table[i], 0, sizeof(table[i]));
+        while (true) {
+            j = (j + 1) & (BASIC_SCHED_SIZE - 1);
+            if (!table[j].used) {
+                return;
+            }
+            const u64 home = basic_sched_hash(table[j].key) & (BASIC_SCHED_SIZE - 1);
+            if (((j - home) & (BASIC_SCHED_SIZE - 1)) >= ((j - i) & (BASIC_SCHED_SIZE - 1))) {
+                break;
+            }
+        }
+        table[i] = table[j];
+        i = j;
+    }
+}
+
+#if BASIC_SCHED_SHADOW
+// whether the old buckets would refuse requests[begin, end)
+static u8 basic_sched_shadow_conflict(const struct basic_sched_status *const shadow,
+                                      const struct basic_sched_request *const r,
+                                      const u64 begin, const u64 end)
+{
+    for (u64 i=begin; i<end; i++) {
+        const struct basic_sched_status *const st = &shadow[r->requests[i].id % BASIC_SCHED_SIZE];
+        if (st->nr_writers > 0 || (r->requests[i].type == WR && st->nr_readers > 0)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void basic_sched_shadow_update(struct basic_sched_status *const shadow,
+                                      const struct basic_sched_request *const r,
+                                      const u64 begin, const u64 end, const int delta)
+{
+    for (u64 i=begin; i<end; i++) {
+        struct basic_sched_status *const st = &shadow[r->requests[i].id % BASIC_SCHED_SIZE];
+        if (r->requests[i].type == WR) {
+            st->nr_writers += delta;
+        } else {
+            st->nr_readers += delta;
+        }
+    }
+}
+#endif
+
+// schedule requests[begin, end), all within one shard. If it cannot run,
+// *blocked is the slot of a key it has to wait for
+static u8 basic_sched_schedule(struct basic_sched_shard *const shard, const struct basic_sched_request *const r,
+                               const u64 begin, const u64 end, u64 *const blocked)
+{
+    struct basic_sched_status *const table = shard->status;
     // first check if all items are available..
-    const struct basic_sched_request *const r = s->worker_meta[tid].request;
-    for (u64 i=0; i<r->nr_requests; i++) {
+    for (u64 i=begin; i<end; i++) {
         const u64 id = r->requests[i].id;
         const access_t type = r->requests[i].type;
+        const u64 slot = basic_sched_find(table, id, r->requests[i].hash);
+        struct basic_sched_status *const st = &table[slot];
+        if (!st->used) {
+            // nobody holds it
+            continue;
+        }
         if (type == WR) {
-            if (s->status[id].nr_readers > 0 || s->status[id].nr_writers > 0) {
-                if (s->status[id].write_requested == 0) {
+            if (st->nr_readers > 0 || st->nr_writers > 0) {
+                if (st->write_requested == 0) {
                     // block future readers..
-                    s->status[id].write_requested = 1;
+                    st->write_requested = 1;
                 }
+                *blocked = slot;
                 return 0;
             }
         } else if (type == RD){
-            if (s->status[id].nr_writers > 0) {
+            if (st->nr_writers > 0) {
+                *blocked = slot;
                 return 0;
             }
         } else {
@@ -53,15 +158,26 @@ static u8 basic_sched_schedule(struct basic_sched *const s, const u64 tid)
         }
     }
 
+#if BASIC_SCHED_SHADOW
+    if (basic_sched_shadow_conflict(shard->shadow, r, begin, end)) {
+        shard->nr_false_conflicts++;
+    }
+    basic_sched_shadow_update(shard->shadow, r, begin, end, 1);
+#endif
     // now it can run.. add its meta and release
-    for (u64 i=0; i<r->nr_requests; i++) {
+    for (u64 i=begin; i<end; i++) {
         const u64 id = r->requests[i].id;
         const access_t type = r->requests[i].type;
+        struct basic_sched_status *const st = &table[basic_sched_find(table, id, r->requests[i].hash)];
+        if (!st->used) {
+            st->used = 1;
+            st->key = id;
+        }
         if (type == WR) {
-            s->status[id].write_requested = 0;
-            s->status[id].nr_writers++;
+            st->write_requested = 0;
+            st->nr_writers++;
         } else if (type == RD){
-            s->status[id].nr_readers++;
+            st->nr_readers++;
         } else {
             printf("basic_sched: request type not WR or RD\n");
             fflush(stdout);
@@ -71,53 +187,264 @@ static u8 basic_sched_schedule(struct basic_sched *const s, const u64 tid)
     return 1;
 }
 
-static void basic_sched_cleanup(struct basic_sched *const s, const u64 tid)
+static void basic_sched_cleanup(struct basic_sched_shard *const shard, const struct basic_sched_request *const r,
+                                const u64 begin, const u64 end)
 {
-    const struct basic_sched_request *const r = s->worker_meta[tid].request;
-    for (u64 i=0; i<r->nr_requests; i++) {
+    struct basic_sched_status *const table = shard->status;
+#if BASIC_SCHED_SHADOW
+    basic_sched_shadow_update(shard->shadow, r, begin, end, -1);
+#endif
+    for (u64 i=begin; i<end; i++) {
         const u64 id = r->requests[i].id;
         const access_t type = r->requests[i].type;
+        const u64 slot = basic_sched_find(table, id, r->requests[i].hash);
+        struct basic_sched_status *const st = &table[slot];
+        assert(st->used);
         if (type == WR) {
-            s->status[id].nr_writers--;
+            st->nr_writers--;
         } else if (type == RD){
-            s->status[id].nr_readers--;
+            st->nr_readers--;
         } else {
             printf("basic_sched: request type not WR or RD\n");
             fflush(stdout);
             exit(1);
         }
+        // a reader leaving other readers behind frees nothing for the waiters
+        if (st->nr_writers == 0 && (type == WR || st->nr_readers == 0)) {
+            while (st->wait_head) {
+                const u32 w = st->wait_head - 1;
+                st->wait_head = shard->wait_next[w];
+                shard->retry[w / 64] |= 1lu << (w % 64);
+            }
+        }
+        basic_sched_reclaim(table, slot);
     }
 }
 
+// tell shard k that worker tid has news for it
+static void basic_sched_ring(struct basic_sched *const s, const u32 k, const u64 tid)
+{
+    struct basic_sched_bell *const bell = &s->bell[k];
+    __sync_fetch_and_or(&bell->bits[tid / 64], 1lu << (tid % 64));
+#if WAIT_STRATEGY == WAIT_FUTEX
+    ATOM_ADD(bell->seq, 1);
+    if (bell->sleeping) {
+        futex_wake(&bell->seq);
+    }
+#endif
+}
+
+// whether worker i waits for this shard to schedule its part
+static u8 basic_sched_is_waiting(const struct basic_sched_shard *const shard, const u64 i)
+{
+    const struct basic_sched *const s = shard->s;
+    return s->worker_meta[i].request != NULL && s->worker_meta[i].signal == BASIC_SCHED_SIGNAL_WAIT
+        && s->worker_meta[i].cursor == shard->id;
+}
+
+static void basic_sched_admit(struct basic_sched_shard *const shard, const u64 i)
+{
+    struct basic_sched *const s = shard->s;
+    const u32 k = shard->id;
+    const struct basic_sched_request *const r = s->worker_meta[i].request;
+    // schedule!
+    const u64 begin = basic_sched_lower_bound(r, k);
+    const u64 end = basic_sched_lower_bound(r, k + 1);
+    u64 blocked;
+    if (basic_sched_schedule(shard, r, begin, end, &blocked)) {
+        shard->granted[i] = 1;
+        shard->nr_scheduled++;
+        s->worker_meta[i].pending++;
+        if (end == r->nr_requests) {
+            s->worker_meta[i].cursor = BASIC_SCHED_THREADS;
+            s->worker_meta[i].signal = BASIC_SCHED_SIGNAL_OK;
+        } else {
+            // hand off to the next shard with a part
+            const u32 next = BASIC_SCHED_SHARD(r->requests[end].hash);
+            s->worker_meta[i].cursor = next;
+            basic_sched_ring(s, next, i);
+        }
+    } else {
+        // retried when the key is released, see basic_sched_cleanup
+        shard->wait_next[i] = shard->status[blocked].wait_head;
+        shard->status[blocked].wait_head = i + 1;
+    }
+}
+
+static void basic_sched_handle(struct basic_sched_shard *const shard, const u64 i)
+{
+    struct basic_sched *const s = shard->s;
+    const u32 k = shard->id;
+    const struct basic_sched_request *const r = s->worker_meta[i].request;
+    if (r == NULL) {
+        return;
+    }
+    if (basic_sched_is_waiting(shard, i)) {
+        if (g_bs_epoch) {
+            shard->batch[i / 64] |= 1lu << (i % 64);
+        } else {
+            basic_sched_admit(shard, i);
+        }
+    } else if (s->worker_meta[i].signal == BASIC_SCHED_SIGNAL_DONE && shard->granted[i]) {
+        basic_sched_cleanup(shard, r, basic_sched_lower_bound(r, k), basic_sched_lower_bound(r, k + 1));
+        shard->granted[i] = 0;
+        // the last shard to release hands the slot back to the worker
+        if (ATOM_SUB_FETCH(s->worker_meta[i].pending, 1) == 0) {
+            s->worker_meta[i].request = NULL;
+            s->worker_meta[i].signal = BASIC_SCHED_SIGNAL_WAIT;
+        }
+    } // else is ok which means the txn is running
+}
+
+// whether the parts of r1 and r2 in [b1, e1) and [b2, e2) share a key that
+// one of them writes. Both are sorted by (hash, id)
+static u8 basic_sched_conflict(const struct basic_sched_request *const r1, u64 b1, const u64 e1,
+                               const struct basic_sched_request *const r2, u64 b2, const u64 e2)
+{
+    while (b1 < e1 && b2 < e2) {
+        const u64 h1 = r1->requests[b1].hash, h2 = r2->requests[b2].hash;
+        const u64 id1 = r1->requests[b1].id, id2 = r2->requests[b2].id;
+        if (h1 < h2 || (h1 == h2 && id1 < id2)) {
+            b1++;
+        } else if (h1 > h2 || id1 > id2) {
+            b2++;
+        } else {
+            if (r1->requests[b1].type == WR || r2->requests[b2].type == WR) {
+                return 1;
+            }
+            b1++;
+            b2++;
+        }
+    }
+    return 0;
+}
+
+// Admit the requests collected in this epoch. Greedy coloring: visit them in
+// ascending order of conflict degree within the batch, so a hot request
+// conflicting with many others does not keep them all out, and admit each
+// one that fits with what is already held. The admitted ones form the first
+// color class; the others wait on their blocking key for the next epochs.
+static void basic_sched_admit_batch(struct basic_sched_shard *const shard)
+{
+    struct basic_sched *const s = shard->s;
+    const u32 k = shard->id;
+    u64 ids[THREAD_CNT];
+    u64 begin[THREAD_CNT], end[THREAD_CNT];
+    u32 degree[THREAD_CNT];
+    u64 n = 0;
+    for (u64 w=0; w<BASIC_SCHED_BELL_WORDS; w++) {
+        while (shard->batch[w]) {
+            const u64 i = w * 64 + __builtin_ctzl(shard->batch[w]);
+            shard->batch[w] &= shard->batch[w] - 1;
+            if (!basic_sched_is_waiting(shard, i)) {
+                continue;
+            }
+            const struct basic_sched_request *const r = s->worker_meta[i].request;
+            ids[n] = i;
+            begin[n] = basic_sched_lower_bound(r, k);
+            end[n] = basic_sched_lower_bound(r, k + 1);
+            degree[n] = 0;
+            n++;
+        }
+    }
+    for (u64 a=0; a<n; a++) {
+        for (u64 b=a+1; b<n; b++) {
+            if (basic_sched_conflict(s->worker_meta[ids[a]].request, begin[a], end[a],
+                                     s->worker_meta[ids[b]].request, begin[b], end[b])) {
+                degree[a]++;
+                degree[b]++;
+            }
+        }
+    }
+    // insertion sort by degree, stable so ties keep the worker order
+    for (u64 a=1; a<n; a++) {
+        const u64 id = ids[a];
+        const u32 d = degree[a];
+        u64 b = a;
+        while (b > 0 && degree[b - 1] > d) {
+            ids[b] = ids[b - 1];
+            degree[b] = degree[b - 1];
+            b--;
+        }
+        ids[b] = id;
+        degree[b] = d;
+    }
+    for (u64 a=0; a<n; a++) {
+        basic_sched_admit(shard, ids[a]);
+    }
+    shard->nr_epochs++;
+}
+
+// Each shard grants its part of a request all-or-nothing, and the parts are
+// granted in ascending shard order while the earlier ones are held, i.e. the
+// shards are ordered locks. So no cycle can form across shards.
+// A shard only looks at the workers that rang its doorbell, and at the
+// blocked ones whose key got released since.
 void *basic_sched_run(void *const sptr)
 {
-	set_affinity(0);
-    printf("basic_sched scheduler starts running\n");
+    struct basic_sched_shard *const shard = (struct basic_sched_shard *const)(sptr);
+    struct basic_sched *const s = shard->s;
+    const u32 k = shard->id;
+    struct basic_sched_bell *const bell = &s->bell[k];
+	set_affinity(k);
+    printf("basic_sched scheduler %u starts running\n", k);
     fflush(stdout);
 
-    struct basic_sched *const s = (struct basic_sched *const)(sptr);
-    s->valid= 1;
-    // now let's just do a basic one without using per-object status
+#if WAIT_STRATEGY == WAIT_FUTEX
+    u64 idle = 0;
+#endif
     while (s->valid == 1) {
-        for (u64 i=0; i<THREAD_CNT; i++) {
-            if (s->worker_meta[i].request != NULL) {
-                if (s->worker_meta[i].signal == BASIC_SCHED_SIGNAL_WAIT) {
-                    // schedule!
-                    const u8 ok = basic_sched_schedule(s, i);
-                    // now request is not null, and signal is wait
-                    if (ok) {
-                        s->worker_meta[i].signal = BASIC_SCHED_SIGNAL_OK;
-                        // basic_sched_print_stat(s, i, "ok");
-                    }
-                    // basic_sched_print_stat(s, i, "not ok");
-                } else if (s->worker_meta[i].signal == BASIC_SCHED_SIGNAL_DONE) {
-                    basic_sched_cleanup(s, i);
-                    // basic_sched_print_stat(s, i, "cleanup");
-                    s->worker_meta[i].request = NULL;
-                    s->worker_meta[i].signal = BASIC_SCHED_SIGNAL_WAIT;
-                } // else is ok which means the txn is running
+#if WAIT_STRATEGY == WAIT_FUTEX
+        const u32 seq = bell->seq;
+#endif
+        u64 events[BASIC_SCHED_BELL_WORDS];
+        u8 any = 0;
+        for (u64 w=0; w<BASIC_SCHED_BELL_WORDS; w++) {
+            const u64 rung = bell->bits[w] ? __sync_lock_test_and_set(&bell->bits[w], 0) : 0;
+            events[w] = rung | shard->retry[w];
+            shard->nr_retries += __builtin_popcountl(shard->retry[w] & ~rung);
+            shard->retry[w] = 0;
+            any |= (events[w] != 0);
+        }
+        for (u64 w=0; w<BASIC_SCHED_BELL_WORDS; w++) {
+            while (events[w]) {
+                const u64 i = w * 64 + __builtin_ctzl(events[w]);
+                events[w] &= events[w] - 1;
+                basic_sched_handle(shard, i);
+            }
+        }
+        u8 batched = 0;
+        if (g_bs_epoch) {
+            for (u64 w=0; w<BASIC_SCHED_BELL_WORDS; w++) {
+                batched |= (shard->batch[w] != 0);
             }
+            if (batched) {
+                const u64 now = get_server_clock();
+                if (now - shard->epoch_start >= g_bs_epoch) {
+                    basic_sched_admit_batch(shard);
+                    shard->epoch_start = now;
+                }
+            }
+        }
+        if (any) {
+#if WAIT_STRATEGY == WAIT_FUTEX
+            idle = 0;
+#endif
+            continue;
+        }
+#if WAIT_STRATEGY == WAIT_FUTEX
+        // do not sleep past the end of the epoch
+        if (!batched && ++idle >= BASIC_SCHED_IDLE_SPIN) {
+            // recheck the bells after announcing the sleep, a worker
+            // bumps seq after setting its bit
+            bell->sleeping = 1;
+            __sync_synchronize();
+            futex_wait(&bell->seq, seq, WAIT_FUTEX_TIMEOUT);
+            bell->sleeping = 0;
+            idle = 0;
         }
+#endif
+        PAUSE
     }
     return NULL;
 }
@@ -131,8 +458,12 @@ void basic_sched_request(struct basic_sched *s, const struct basic_sched_request
         fflush(stdout);
         exit(1);
     }
-    // put request in
+    assert(r->nr_requests > 0);
+    // put request in, the first shard can only see the cursor with the request
+    s->worker_meta[tid].cursor = BASIC_SCHED_SHARD(r->requests[0].hash);
+    COMPILER_BARRIER
     s->worker_meta[tid].request = r;
+    basic_sched_ring(s, s->worker_meta[tid].cursor, tid);
     // wait
     while (s->worker_meta[tid].signal != BASIC_SCHED_SIGNAL_OK);
     return;
@@ -148,6 +479,13 @@ void basic_sched_finish(struct basic_sched *const s, const struct basic_sched_re
         exit(1);
     }
     s->worker_meta[tid].signal = BASIC_SCHED_SIGNAL_DONE;
+    // every shard with a part of the request holds it
+    for (u64 i=0; i<r->nr_requests; i++) {
+        const u32 k = BASIC_SCHED_SHARD(r->requests[i].hash);
+        if (i == 0 || k != BASIC_SCHED_SHARD(r->requests[i - 1].hash)) {
+            basic_sched_ring(s, k, tid);
+        }
+    }
     while (s->worker_meta[tid].signal != BASIC_SCHED_SIGNAL_WAIT);
     // the scheduler thread will clean request internally
     return;
@@ -3,7 +3,26 @@
 
 #include "row_sched.h"
 
+// slots of the conflict table of each shard, must be a power of 2
 #define BASIC_SCHED_SIZE (1lu << 14)
+// shard k owns the hash range [k, k + 1) * 2^64 / BASIC_SCHED_THREADS
+#define BASIC_SCHED_SHARD(hash) ((u32)((((hash) >> 32) * BASIC_SCHED_THREADS) >> 32))
+
+// an entry only lives while some running txn holds the key, keep the load
+// factor of a table at most 1/2 even if all keys land in one shard
+static_assert(BASIC_SCHED_SIZE >= 2 * THREAD_CNT * MAX_ROW_PER_TXN,
+              "BASIC_SCHED_SIZE too small for THREAD_CNT * MAX_ROW_PER_TXN");
+
+// murmur3 finalizer
+static inline u64 basic_sched_hash(u64 key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdlu;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53lu;
+    key ^= key >> 33;
+    return key;
+}
 
 // per-txn signal
 enum basic_sched_signal {
@@ -12,22 +31,69 @@ enum basic_sched_signal {
     BASIC_SCHED_SIGNAL_DONE = 2,
 };
 
-// per-object status
+// per-object status, a slot of the conflict table
 struct basic_sched_status {
+    u64 key;
     u32 nr_readers;
     u32 nr_writers;
+    u32 wait_head; // 1 + first worker blocked on this key, 0 if none
+    u8 used;
     u8 write_requested; // avoid starvation
 };
 
+#define BASIC_SCHED_BELL_WORDS ((THREAD_CNT + 63) / 64)
+
+// per-shard doorbell, a bit per worker with news for the shard: a request
+// handed to it, or a request it granted a part of being done
+struct basic_sched_bell {
+    volatile u64 bits[BASIC_SCHED_BELL_WORDS];
+    // WAIT_FUTEX only, the idle scheduler sleeps on seq
+    volatile u32 seq;
+    volatile u32 sleeping;
+    u64 _[8];
+};
+
 struct basic_sched_request {
     u64 tid;
     u64 nr_requests;
+    // sorted by hash, see txn_man::bs_regulate_request
     struct {
         u64 id;
+        u64 hash;
         access_t type;
     } requests[MAX_ROW_PER_TXN];
 };
 
+struct basic_sched;
+
+// private for one scheduler thread
+struct basic_sched_shard {
+    struct basic_sched *s;
+    u64 id;
+    u64 nr_scheduled;
+    // requests retried after a key they were blocked on got released
+    u64 nr_retries;
+    // batch mode (g_bs_epoch > 0): requests waiting for the end of the epoch
+    u64 batch[BASIC_SCHED_BELL_WORDS];
+    u64 epoch_start;
+    u64 nr_epochs;
+    // grants the old key % BASIC_SCHED_SIZE buckets would have refused
+    u64 nr_false_conflicts;
+    // open-addressing table with linear probing, keyed by the exact key
+    struct basic_sched_status *status;
+#if BASIC_SCHED_SHADOW
+    // the old scheme, indexed by key % BASIC_SCHED_SIZE
+    struct basic_sched_status *shadow;
+#endif
+    // whether this shard granted its part of the worker's request
+    u8 granted[THREAD_CNT];
+    // wait lists of the keys, 1 + next blocked worker
+    u32 wait_next[THREAD_CNT];
+    // workers whose blocking key got released
+    u64 retry[BASIC_SCHED_BELL_WORDS];
+    u64 _[8];
+};
+
 // remember to cl alloc this struct
 struct basic_sched {
     union {
@@ -35,16 +101,20 @@ struct basic_sched {
         u64 _0[8];
     };
     // per-worker memory, separated by cache lines
+    // A request is granted shard by shard in ascending order: cursor is the
+    // shard whose part is to be scheduled next (BASIC_SCHED_THREADS if none),
+    // pending is the number of shards holding a part of the request.
     union {
         struct {
             const struct basic_sched_request *request;
             volatile enum basic_sched_signal signal;
+            volatile u32 cursor;
+            volatile u32 pending;
         };
         u64 _[8];
     } worker_meta[THREAD_CNT];
-    // private for scheduler
-    u64 _1[8];
-    struct basic_sched_status status[BASIC_SCHED_SIZE];
+    struct basic_sched_bell bell[BASIC_SCHED_THREADS];
+    struct basic_sched_shard shard[BASIC_SCHED_THREADS];
 };
 
 static_assert(sizeof(((struct basic_sched *)NULL)->worker_meta[0]) == 64);
@@ -52,6 +122,7 @@ static_assert(sizeof(((struct basic_sched *)NULL)->worker_meta[0]) == 64);
 // for scheduler
 struct basic_sched *basic_sched_create();
 
+// sptr is a struct basic_sched_shard
 void *basic_sched_run(void *sptr);
 
 // for clients
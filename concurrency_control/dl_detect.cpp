@@ -6,84 +6,135 @@
 #include "manager.h"
 #include "mem_alloc.h"
 
+#define DL_TEST(bits, thd) ((bits)[(thd) / 64] & (1UL << ((thd) % 64)))
+#define DL_SET(bits, thd) ((bits)[(thd) / 64] |= (1UL << ((thd) % 64)))
+#define DL_CLR(bits, thd) ((bits)[(thd) / 64] &= ~(1UL << ((thd) % 64)))
+
 /********************************************************/
-// The current txn aborts itself only if it holds less
-// locks than all the other txns on the loop.
-// In other words, the victim should be the txn that
-// performs the least amount of work
+// The victim of a loop is picked by DL_VICTIM_POLICY: the
+// txn that holds the fewest locks, started first the latest
+// or started its current attempt the latest. In other words,
+// the victim should be the txn that loses the least work.
 /********************************************************/
 void DL_detect::init() {
-	dependency = new DepThd[g_thread_cnt];
+	assert(g_thread_cnt <= THREAD_CNT);
+	dependency = (DepThd *) _mm_malloc(sizeof(DepThd) * g_thread_cnt, 64);
+	detect_data = (DetectData *) _mm_malloc(sizeof(DetectData) * g_thread_cnt, 64);
+	memset((void *)dependency, 0, sizeof(DepThd) * g_thread_cnt);
+	for (UInt32 i = 0; i < g_thread_cnt; i++)
+		dependency[i].txnid = -1;
 	V = g_thread_cnt;
+	victim = (int64_t *) _mm_malloc(sizeof(int64_t) * g_thread_cnt, 64);
+	for (UInt32 i = 0; i < g_thread_cnt; i++)
+		victim[i] = -1;
+	nr_passes = 0;
+	nr_deadlocks = 0;
+	nr_dups = 0;
+	time_detect = 0;
+	running = true;
 }
 
 int
-DL_detect::add_dep(uint64_t txnid1, uint64_t * txnids, int cnt, int num_locks) {
+DL_detect::add_dep(txn_man * txn, uint64_t * txnids, int cnt) {
 	if (g_no_dl)
 		return 0;
+	uint64_t txnid1 = txn->get_txn_id();
 	int thd1 = get_thdid_from_txnid(txnid1);
-	pthread_mutex_lock( &dependency[thd1].lock );
-	dependency[thd1].txnid = txnid1;
-	dependency[thd1].num_locks = num_locks;
-
+	uint64_t adj[DL_WORDS] = {0};
 	for (int i = 0; i < cnt; i++)
-		dependency[thd1].adj.push_back(txnids[i]);
-
-	pthread_mutex_unlock( &dependency[thd1].lock );
+		DL_SET(adj, get_thdid_from_txnid(txnids[i]));
+
+	DepThd * dep = &dependency[thd1];
+	dep->seq ++;
+	COMPILER_BARRIER
+	for (int w = 0; w < DL_WORDS; w++)
+		dep->adj[w] = adj[w];
+	dep->txnid = txnid1;
+	dep->num_locks = txn->row_cnt;
+	dep->first_start = txn->first_starttime;
+	dep->attempt_start = txn->attempt_starttime;
+	COMPILER_BARRIER
+	dep->seq ++;
 	return 0;
 }
 
+// a consistent copy of the dependencies of thd
+void
+DL_detect::snapshot(int thd, DepSnap * snap) {
+	DepThd * dep = &dependency[thd];
+	while (true) {
+		uint64_t seq = dep->seq;
+		if (seq & 1) {
+			PAUSE
+			continue;
+		}
+		COMPILER_BARRIER
+		for (int w = 0; w < DL_WORDS; w++)
+			snap->adj[w] = dep->adj[w];
+		snap->txnid = dep->txnid;
+		snap->num_locks = dep->num_locks;
+		snap->first_start = dep->first_start;
+		snap->attempt_start = dep->attempt_start;
+		COMPILER_BARRIER
+		if (dep->seq == seq)
+			return;
+	}
+}
+
+uint64_t
+DL_detect::victim_key(DepSnap * snap) {
+#if DL_VICTIM_POLICY == DL_VICTIM_LOCKS
+	return snap->num_locks;
+#elif DL_VICTIM_POLICY == DL_VICTIM_YOUNGEST
+	return UINT64_MAX - snap->first_start;
+#elif DL_VICTIM_POLICY == DL_VICTIM_WORK
+	return UINT64_MAX - snap->attempt_start;
+#endif
+}
+
 bool
 DL_detect::nextNode(uint64_t txnid, DetectData * detect_data) {
 	int thd = get_thdid_from_txnid(txnid);
-	assert( !detect_data->visited[thd] );
-	detect_data->visited[thd] = true;
-	detect_data->recStack[thd] = true;
-
-	pthread_mutex_lock( &dependency[thd].lock );
-
-	int lock_num = dependency[thd].num_locks;
-	int txnid_num = dependency[thd].adj.size();
-	uint64_t txnids[ txnid_num ];
-	int n = 0;
+	assert( !DL_TEST(detect_data->visited, thd) );
+	DL_SET(detect_data->visited, thd);
 
-	if (dependency[thd].txnid != (SInt64)txnid) {
-		detect_data->recStack[thd] = false;
-		pthread_mutex_unlock( &dependency[thd].lock );
+	DepSnap snap;
+	snapshot(thd, &snap);
+	// only a txn that still waits can be on a loop
+	if (snap.txnid != (SInt64)txnid)
 		return false;
-	}
-
-	for(list<uint64_t>::iterator i = dependency[thd].adj.begin(); i != dependency[thd].adj.end(); ++i) {
-		txnids[n++] = *i;
-	}
+	DL_SET(detect_data->recStack, thd);
 
-	pthread_mutex_unlock( &dependency[thd].lock );
+	for (int w = 0; w < DL_WORDS && !detect_data->loop; w++) {
+		uint64_t bits = snap.adj[w];
+		while (bits) {
+			int nextthd = w * 64 + __builtin_ctzl(bits);
+			bits &= bits - 1;
 
-	for (n = 0; n < txnid_num; n++) {
-		int nextthd = get_thdid_from_txnid( txnids[n] );
-
-		// next node not visited and txnid is not stale
-		if ( detect_data->recStack[nextthd] ) {
-			if ((SInt32)txnids[n] == dependency[nextthd].txnid) {
+			if ( DL_TEST(detect_data->recStack, nextthd) ) {
 				detect_data->loop = true;
 				detect_data->onloop = true;
 				detect_data->loopstart = nextthd;
 				break;
 			}
-		}
-		if ( !detect_data->visited[nextthd] &&
-			dependency[nextthd].txnid == (SInt64) txnids[n] &&
-			nextNode(txnids[n], detect_data))
-		{
-			break;
+			int64_t nexttxn = dependency[nextthd].txnid;
+			// next node not visited and waiting as well
+			if ( !DL_TEST(detect_data->visited, nextthd) && nexttxn != -1 &&
+				nextNode(nexttxn, detect_data))
+			{
+				break;
+			}
 		}
 	}
-	detect_data->recStack[thd] = false;
-	if (detect_data->loop
-			&& detect_data->onloop
-			&& lock_num < detect_data->min_lock_num) {
-		detect_data->min_lock_num = lock_num;
-		detect_data->min_txnid = txnid;
+	DL_CLR(detect_data->recStack, thd);
+	if (detect_data->loop && detect_data->onloop) {
+		uint64_t key = victim_key(&snap);
+		if (key < detect_data->min_key) {
+			detect_data->min_key = key;
+			detect_data->min_txnid = txnid;
+		}
+		if (victim[thd] == (SInt64) txnid)
+			detect_data->resolved = true;
 	}
 	if (thd == detect_data->loopstart) {
 		detect_data->onloop = false;
@@ -101,55 +152,98 @@ int
 DL_detect::detect_cycle(uint64_t txnid) {
 	if (g_no_dl)
 		return 0;
-	uint64_t starttime = get_sys_clock();
-	INC_GLOB_STATS(cycle_detect, 1);
+	uint64_t starttime = get_server_clock();
 	bool deadlock = false;
 
 	int thd = get_thdid_from_txnid(txnid);
-	DetectData * detect_data = (DetectData *)
-		mem_allocator.alloc(sizeof(DetectData), thd);
-	detect_data->visited = (bool * )
-		mem_allocator.alloc(sizeof(bool) * V, thd);
-	detect_data->recStack = (bool * )
-		mem_allocator.alloc(sizeof(bool) * V, thd);
-	for(int i = 0; i < V; i++) {
-        detect_data->visited[i] = false;
-		detect_data->recStack[i] = false;
-	}
-
-	detect_data->min_lock_num = 1000;
-	detect_data->min_txnid = -1;
-	detect_data->loop = false;
+	INC_STATS(thd, dl_detect_cnt, 1);
+	DetectData * detect_data = &this->detect_data[thd];
+	reset(detect_data);
 
 	if ( isCyclic(txnid, detect_data) ){
 		deadlock = true;
-		INC_GLOB_STATS(deadlock, 1);
+		INC_STATS(thd, dl_deadlock_cnt, 1);
 		int thd_to_abort = get_thdid_from_txnid(detect_data->min_txnid);
 		if (dependency[thd_to_abort].txnid == (SInt64) detect_data->min_txnid) {
 			txn_man * txn = glob_manager->get_txn_man(thd_to_abort);
-			txn->lock_abort = true;
+			txn->set_lock_abort();
 		}
 	}
 
-	mem_allocator.free(detect_data->visited, sizeof(bool)*V);
-	mem_allocator.free(detect_data->recStack, sizeof(bool)*V);
-	mem_allocator.free(detect_data, sizeof(DetectData));
-	uint64_t timespan = get_sys_clock() - starttime;
-	INC_GLOB_STATS(dl_detect_time, timespan);
+	INC_STATS(thd, time_dl_detect, get_server_clock() - starttime);
 	if (deadlock) return 1;
 	else return 0;
 }
 
+void
+DL_detect::reset(DetectData * detect_data) {
+	for (int w = 0; w < DL_WORDS; w++) {
+		detect_data->visited[w] = 0;
+		detect_data->recStack[w] = 0;
+	}
+
+	detect_data->min_key = UINT64_MAX;
+	detect_data->min_txnid = -1;
+	detect_data->loop = false;
+	detect_data->onloop = false;
+	detect_data->resolved = false;
+	detect_data->loopstart = -1;
+}
+
+// one pass over the graph, starting from every waiting txn. A loop is
+// found from each of its txns, only the first finding signals a victim.
+// The victim stays in the graph until it wakes up, later passes find the
+// loop again and count it as a duplicate as well.
+void
+DL_detect::scan() {
+	uint64_t starttime = get_server_clock();
+	// the waiters never run detect_cycle() here, use their buffer
+	DetectData * detect_data = &this->detect_data[0];
+	for (int thd = 0; thd < V; thd++) {
+		int64_t txnid = dependency[thd].txnid;
+		if (txnid == -1)
+			continue;
+		reset(detect_data);
+		if (!isCyclic(txnid, detect_data))
+			continue;
+		if (detect_data->resolved) {
+			nr_dups ++;
+			continue;
+		}
+		int thd_to_abort = get_thdid_from_txnid(detect_data->min_txnid);
+		if (dependency[thd_to_abort].txnid == (SInt64) detect_data->min_txnid) {
+			nr_deadlocks ++;
+			victim[thd_to_abort] = detect_data->min_txnid;
+			glob_manager->get_txn_man(thd_to_abort)->set_lock_abort();
+		}
+	}
+	nr_passes ++;
+	time_detect += get_server_clock() - starttime;
+}
+
+void *
+DL_detect::run(void * detector) {
+	DL_detect * dl = (DL_detect *) detector;
+	while (dl->running) {
+		usleep(g_dl_loop_detect / 1000);
+		dl->scan();
+	}
+	return NULL;
+}
+
 void DL_detect::clear_dep(uint64_t txnid) {
 	if (g_no_dl)
 		return;
 	int thd = get_thdid_from_txnid(txnid);
-	pthread_mutex_lock( &dependency[thd].lock );
-
-	dependency[thd].adj.clear();
-	dependency[thd].txnid = -1;
-	dependency[thd].num_locks = 0;
-
-	pthread_mutex_unlock( &dependency[thd].lock );
+	DepThd * dep = &dependency[thd];
+	if (dep->txnid == -1)
+		return;
+	dep->seq ++;
+	COMPILER_BARRIER
+	for (int w = 0; w < DL_WORDS; w++)
+		dep->adj[w] = 0;
+	dep->txnid = -1;
+	dep->num_locks = 0;
+	COMPILER_BARRIER
+	dep->seq ++;
 }
-
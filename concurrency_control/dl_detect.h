@@ -2,32 +2,49 @@
 #define _DL_DETECT_
 
 #include <limits.h>
-#include <list>
 #include <stdint.h>
 #include "pthread.h"
 #include "config.h"
 //#include "global.h"
 //#include "helper.h"
 
-// The denpendency information per thread
-struct DepThd {
-    std::list<uint64_t> adj;    // Pointer to an array containing adjacency lists
-	pthread_mutex_t lock;
-	volatile int64_t txnid; 				// -1 means invalid
-	int num_locks;				// the # of locks that txn is currently holding
-	char pad[2 * CL_SIZE - sizeof(int64_t) - sizeof(pthread_mutex_t) - sizeof(std::list<uint64_t>) - sizeof(int)];
+#define DL_WORDS ((THREAD_CNT + 63) / 64)
+
+class txn_man;
+
+// The denpendency information per thread. Only the owner thread writes it,
+// under seq (odd while an update is in progress), so detectors take
+// consistent snapshots without locking. Each entry takes whole cache lines.
+struct __attribute__((aligned(CL_SIZE))) DepThd {
+	volatile uint64_t adj[DL_WORDS];	// the threads the waiting txn waits for
+	volatile int64_t txnid; 			// the waiting txn, -1 means not waiting
+	volatile int num_locks;				// the # of locks that txn is currently holding
+	volatile uint64_t first_start;		// the txn's first start, kept across restarts
+	volatile uint64_t attempt_start;	// the start of the current attempt
+	volatile uint64_t seq;
 };
+static_assert(sizeof(DepThd) % CL_SIZE == 0, "DepThd shares a cache line");
 
-// shared data for a particular deadlock detection
-struct DetectData {
-	bool * visited;
-	bool * recStack;
+struct DepSnap {
+	uint64_t adj[DL_WORDS];
+	int64_t txnid;
+	int num_locks;
+	uint64_t first_start;
+	uint64_t attempt_start;
+};
+
+// shared data for a particular deadlock detection, one per thread
+struct __attribute__((aligned(CL_SIZE))) DetectData {
+	uint64_t visited[DL_WORDS];
+	uint64_t recStack[DL_WORDS];
 	bool loop;
 	bool onloop;		// the current node is on the loop
+	bool resolved;		// a txn on the loop has been picked as victim already
 	int loopstart;		// the starting point of the loop
-	int min_lock_num; 	// the min lock num for txn in the loop
-	uint64_t min_txnid; // the txnid that holds the min lock num
+	uint64_t min_key; 	// the min victim_key() for txn in the loop
+	uint64_t min_txnid; // the txnid that has the min key
 };
+static_assert(sizeof(DetectData) % CL_SIZE == 0, "DetectData shares a cache line");
 
 class DL_detect {
 public:
@@ -36,23 +53,34 @@ public:
 	// 	0: no deadlocks
 	//  1: deadlock exists
 	int detect_cycle(uint64_t txnid);
-	// txn1 (txn_id) dependes on txns (containing cnt txns)
+	// txn waits for txns (containing cnt txns), replacing the dependencies
+	// of its previous wait
 	// return values:
 	//	0: succeed.
-	//	16: cannot get lock
-	int add_dep(uint64_t txnid, uint64_t * txnids, int cnt, int num_locks);
-	// remove all outbound dependencies for txnid.
-	// will wait for the lock until acquired.
+	int add_dep(txn_man * txn, uint64_t * txnids, int cnt);
+	// remove all outbound dependencies for txnid, once it stops waiting.
 	void clear_dep(uint64_t txnid);
+
+	// [DL_DETECT_THREAD] the detector thread, scans the graph until stop()
+	static void * run(void * detector);
+	void stop() { running = false; };
+	uint64_t nr_passes;
+	uint64_t nr_deadlocks;
+	uint64_t nr_dups;		// cycles found again after their victim was signalled
+	uint64_t time_detect;
 private:
 	int V;    // No. of vertices
 	DepThd * dependency;
+	DetectData * detect_data;
+	// [DL_DETECT_THREAD] the txnid last signalled as victim, per thread
+	int64_t * victim;
+	volatile bool running;
 
-	///////////////////////////////////////////
-	// For deadlock detection
-	///////////////////////////////////////////
-	// dl_lock is the global lock. Only used when deadlock detection happens
-	pthread_mutex_t _lock;
+	void snapshot(int thd, DepSnap * snap);
+	// the victim of a loop is the txn with the smallest key
+	uint64_t victim_key(DepSnap * snap);
+	void reset(DetectData * detect_data);
+	void scan();
 	// return value: whether a loop is detected.
 	bool nextNode(uint64_t txnid, DetectData * detect_data);
 	bool isCyclic(uint64_t txnid, DetectData * detect_data); // return if "thd" is causing a cycle
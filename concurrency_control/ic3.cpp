@@ -350,18 +350,16 @@ txn_man::validate_ic3() {
 #endif
 #if COMMUTATIVE_OPS
       // commutative ops
-      if (access->com_op != COM_NONE ) {
+      if (access->com_cnt != 0) {
 #if IC3_FIELD_LOCKING
-        access->orig_row->manager->update_version(access->com_col, get_txn_id());
+        for (int j = 0; j < access->com_cnt; j++)
+          access->orig_row->manager->update_version(access->com_ops[j].col,
+                                                    get_txn_id());
 #else
         if (access->type == RD)
           access->orig_row->manager->update_version(get_txn_id());
 #endif
-        if (access->com_op == COM_INC)
-          access->orig_row->inc_value(access->com_col, access->com_val);
-        else
-          access->orig_row->dec_value(access->com_col, access->com_val);
-        access->com_op = COM_NONE;
+        apply_merge_ops(access);
       }
 #endif
   }
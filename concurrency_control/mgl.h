@@ -0,0 +1,72 @@
+#pragma once
+
+#include "global.h"
+
+// [TPCC_MGL] multi-granularity lock over a group of rows (the stock rows of
+// one warehouse). A txn holds the group either in X, which covers every row
+// of the group so the row locks are skipped, or in IX, and then locks the rows
+// it touches as usual. X is only tried while the group is cold and never
+// waits. An IX that finds X held waits at most TPCC_MGL_WAIT for the holder to
+// commit and then aborts, so the group lock can never close a deadlock with
+// the row locks.
+#define MGL_ENABLE (TPCC_MGL && WORKLOAD == TPCC && (CC_ALG == NO_WAIT || \
+    CC_ALG == WAIT_DIE || CC_ALG == DL_DETECT || CC_ALG == BAMBOO))
+#define MGL_MAX_PER_TXN     16
+#define MGL_X               (1UL << 63)
+
+class MGLock {
+  public:
+    void init() {
+        word = 0;
+        contention = 0;
+    };
+    // fewer than TPCC_MGL_COLD/512 of the recent acquisitions saw another
+    // holder, so X is likely to succeed and cheap for the others
+    bool is_cold() { return contention < TPCC_MGL_COLD; };
+    bool try_x() {
+        bool ok = (word == 0) && ATOM_CAS(word, 0, MGL_X);
+        update_contention(ok? 0 : 16);
+        return ok;
+    };
+    bool try_ix() {
+        uint64_t w = ATOM_ADD_FETCH(word, 1);
+        if (w & MGL_X) {
+            ATOM_SUB(word, 1);
+            return false;
+        }
+        update_contention(w != 1? 16 : 0);
+        return true;
+    };
+    bool get_ix() {
+        if (try_ix())
+            return true;
+        uint64_t start = get_server_clock();
+        while (get_server_clock() - start < TPCC_MGL_WAIT) {
+            sched_yield();
+            if (!(word & MGL_X) && try_ix())
+                return true;
+        }
+        // an abort costs a whole txn, keep the group hot for a while
+        update_contention(128);
+        return false;
+    };
+    // X may see transient IX counts of failed try_ix, so subtract instead
+    // of storing 0
+    void release(bool x) {
+        if (x)
+            ATOM_SUB(word, MGL_X);
+        else
+            ATOM_SUB(word, 1);
+    };
+
+  private:
+    // ewma (x512) of acquisitions that found another holder, aborts weigh
+    // 8x. racy on purpose, it shares the line with word which is written
+    // anyway
+    void update_contention(uint32_t weight) {
+        contention = contention - ((contention + 31) >> 5) + weight;
+    };
+    uint64_t volatile   word; // MGL_X | number of IX holders
+    uint32_t            contention;
+    uint8_t             padding[64 - sizeof(uint64_t) - sizeof(uint32_t)];
+};
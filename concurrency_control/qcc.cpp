@@ -1,24 +1,212 @@
 #include "txn.h"
 #include "row.h"
 #include "row_qcc.h"
+#include "catalog.h"
+#include "wl.h"
 
 #if CC_ALG == QCC
 
+// A redo record is followed by the len bytes of the column, padded to 8. A
+// column has at most one record, later writes update its bytes in place.
+struct qcc_redo_rec {
+    row_t *row;
+    u32 pos;
+    u32 len;
+};
+
+#define QCC_REDO_REC_SIZE(len) (sizeof(struct qcc_redo_rec) + (((len) + 7) & ~7UL))
+
 RC
 txn_man::qcc_commit()
 {
-    for (int i = 0; i < row_cnt; i++) {
-        Access * access = accesses[i];
-        if (access->type != WR) {
-            // make sure here the data is exactly the original row w/o modifications
-            assert(access->data == access->orig_row);
-            continue;
+    // only the written columns go back to the rows
+    for (u64 off = 0; off < redo_len; ) {
+        struct qcc_redo_rec *rec = (struct qcc_redo_rec *)&redo[off];
+        rec->row->manager->write(rec->pos, (char *)(rec + 1), rec->len);
+        off += QCC_REDO_REC_SIZE(rec->len);
+    }
+    return RCOK;
+}
+
+// the bytes of column id of the local copy in the redo log, a new record
+// starts out with the committed value
+char *
+txn_man::qcc_redo_col(row_t *local, int id)
+{
+    Catalog *schema = local->get_schema();
+    const u32 pos = schema->get_field_index(id);
+    char *col = qcc_redo_find(local->orig, pos);
+    if (col)
+        return col;
+    const u32 len = schema->get_field_size(id);
+    assert(redo_len + QCC_REDO_REC_SIZE(len) <= QCC_REDO_SIZE);
+    struct qcc_redo_rec *rec = (struct qcc_redo_rec *)&redo[redo_len];
+    rec->row = local->orig;
+    rec->pos = pos;
+    rec->len = len;
+    col = (char *)(rec + 1);
+    memcpy(col, &local->orig->get_data()[pos], len);
+    redo_len += QCC_REDO_REC_SIZE(len);
+    return col;
+}
+
+char *
+txn_man::qcc_redo_find(row_t *row, u32 pos)
+{
+    for (u64 off = 0; off < redo_len; ) {
+        struct qcc_redo_rec *rec = (struct qcc_redo_rec *)&redo[off];
+        if (rec->row == row && rec->pos == pos)
+            return (char *)(rec + 1);
+        off += QCC_REDO_REC_SIZE(rec->len);
+    }
+    return NULL;
+}
+
+// How many speculative runs the next txn of this type may do while it waits
+// for its turn. A speculative run is wasted whenever the snapshot turns out
+// inconsistent, so scale max_try by the fraction of runs that were used, down
+// to pure waiting. An occasional probe keeps the estimate up to date.
+u64
+txn_man::qcc_spec_budget(u32 type, u64 max_try)
+{
+#if QCC_SPEC_ADAPTIVE
+    const u64 budget = (max_try * spec_hit[type] + 512) / 1024;
+    if (budget == 0 && spec_txns[type] % QCC_SPEC_PROBE == 0) {
+        spec_txns[type]++;
+        return 1;
+    }
+    spec_txns[type]++;
+    return budget;
+#else
+    return max_try;
+#endif
+}
+
+// runs speculative runs were done, used if the last one became the result
+void
+txn_man::qcc_spec_result(u32 type, u64 runs, bool used)
+{
+    if (runs == 0)
+        return;
+    const u64 wasted = used ? runs - 1 : runs;
+    INC_STATS(get_thd_id(), qcc_spec_runs, runs);
+    INC_STATS(get_thd_id(), qcc_spec_wasted, wasted);
+    for (u64 i = 0; i < wasted; i++)
+        spec_hit[type] -= spec_hit[type] >> 4;
+    if (used)
+        spec_hit[type] += (1024 - spec_hit[type]) >> 4;
+}
+
+// the check at the txn's turn, which decides whether the last speculative
+// run is used
+u8
+txn_man::qcc_spec_consistent()
+{
+    const u8 ok = qcc_snapshot_consistent();
+    INC_STATS(get_thd_id(), qcc_spec_checks, 1);
+    if (ok)
+        INC_STATS(get_thd_id(), qcc_spec_hits, 1);
+    return ok;
+}
+
+// Multi-partition txns enqueue in all of their partitions under this latch,
+// in ascending partition order. Two of them are then ordered the same way in
+// every partition they share, and a single-partition txn is only in one
+// queue set, so the waits cannot form a cycle across partitions.
+static volatile u64 qcc_mp_latch = 0;
+
+// rows[] and row_part[] are filled in by the benchmark, row_buffer[] keeps
+// the query order and is not touched
+void
+txn_man::qcc_enqueue()
+{
+    for (u64 i = 1; i < nr_rows; i++) {
+        const struct qcc_rvec row = rows[i];
+        const u64 part = row_part[i];
+        u64 j = i;
+        while (j > 0 && row_part[j - 1] > part) {
+            rows[j] = rows[j - 1];
+            row_part[j] = row_part[j - 1];
+            j--;
+        }
+        rows[j] = row;
+        row_part[j] = part;
+    }
+    nr_parts = 0;
+    for (u64 i = 0; i < nr_rows; i++) {
+        if (nr_parts == 0 || row_part[i] != row_part[i - 1]) {
+            struct qcc *const q = h_wl->q[row_part[i]];
+            parts[nr_parts].q = q;
+            parts[nr_parts].txn = qcc_txn_acquire(q, get_thd_id());
+            assert(parts[nr_parts].txn);
+            parts[nr_parts].row_start = i;
+            parts[nr_parts].nr_rows = 0;
+            parts[nr_parts].nr_queues = 0;
+            nr_parts++;
         }
-        // then here.. make sure we copy from buf to orig row
-        assert(access->data == access->buf);
+        parts[nr_parts - 1].nr_rows++;
+    }
+    if (nr_parts > 1) {
+        INC_STATS(get_thd_id(), qcc_mp_cnt, 1);
+        while (qcc_mp_latch || !ATOM_CAS(qcc_mp_latch, 0, 1))
+            PAUSE
+    }
+    // a partition has at most as many queues as rows
+    for (u32 i = 0; i < nr_parts; i++) {
+        const u32 start = parts[i].row_start;
+        qcc_txn_enqueue(parts[i].q, parts[i].txn, &rows[start], parts[i].nr_rows,
+                &queues[start], &parts[i].nr_queues);
+    }
+    if (nr_parts > 1) {
+        COMPILER_BARRIER
+        qcc_mp_latch = 0;
+    }
+}
 
-        access->orig_row->manager->write(access->data);
+u8
+txn_man::qcc_try_wait()
+{
+    for (u32 i = 0; i < nr_parts; i++) {
+        if (!qcc_txn_try_wait(parts[i].q, parts[i].txn))
+            return 0;
     }
-    return RCOK;
+    return 1;
+}
+
+void
+txn_man::qcc_wait()
+{
+    for (u32 i = 0; i < nr_parts; i++)
+        qcc_txn_wait(parts[i].q, parts[i].txn);
+}
+
+void
+txn_man::qcc_snapshot()
+{
+    for (u32 i = 0; i < nr_parts; i++)
+        qcc_txn_snapshot(parts[i].q, parts[i].txn, &rows[parts[i].row_start],
+                parts[i].nr_rows);
+}
+
+u8
+txn_man::qcc_snapshot_consistent()
+{
+    for (u32 i = 0; i < nr_parts; i++) {
+        const u32 start = parts[i].row_start;
+        if (!qcc_txn_snapshot_consistent(parts[i].q, parts[i].txn, &rows[start],
+                    parts[i].nr_rows, parts[i].nr_rows))
+            return 0;
+    }
+    return 1;
+}
+
+// done with all of the txn's queues
+void
+txn_man::qcc_announce()
+{
+    for (u32 i = 0; i < nr_parts; i++)
+        qcc_txn_finish(parts[i].q, parts[i].txn, &queues[parts[i].row_start],
+                parts[i].nr_queues);
+    nr_parts = 0;
 }
 #endif
@@ -11,11 +11,22 @@ void Row_bamboo::init(row_t * row) {
     // waiter is a doubly linked list
     waiters_head = NULL;
     waiters_tail = NULL;
+#if BB_WAITER_SKIPLIST
+    for (int lvl = 0; lvl < BB_WAITER_LEVELS - 1; lvl++)
+        skip_head[lvl] = NULL;
+#endif
     // retired is a doubly linked list
     retired_head = NULL;
     retired_tail = NULL;
     waiter_cnt = 0;
     retired_cnt = 0;
+#if BB_ADAPTIVE_RETIRE
+    contention = 0;
+#endif
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    fast_readers = 0;
+    last_retired_wr = NULL;
+#endif
     // init latches
 #if LATCH == LH_SPINLOCK
     latch = new pthread_spinlock_t;
@@ -79,6 +90,25 @@ RC Row_bamboo::lock_get(lock_t type, txn_man * txn, Access * access) {
 #if PF_MODEL
     INC_STATS(txn->get_thd_id(), lock_acquire_cnt, 1);
 #endif
+#if !BB_DYNAMIC_TS
+    // [pre-assigned ts] assign ts if does not have one. Also before the fast
+    // path, materialize_reader() compares fast readers by it later
+    if (txn->get_ts() == 0)
+        txn->set_next_ts(1);
+#endif
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    // readers of a row without writers, or going to the retired tail, do not
+    // need the latch
+    if (type == LOCK_SH && (fast_lock_get(to_insert) ||
+                            append_lock_get(to_insert))) {
+#if PF_MODEL
+        if (to_insert->is_cohead)
+            INC_STATS(txn->get_thd_id(), lock_directly_cnt, 1);
+#endif
+        txn->lock_ready = true;
+        return rc;
+    }
+#endif
 #if PF_CS
     uint64_t starttime = get_sys_clock();
 #endif
@@ -89,17 +119,21 @@ RC Row_bamboo::lock_get(lock_t type, txn_man * txn, Access * access) {
     uint64_t endtime = get_sys_clock();
     INC_STATS(txn->get_thd_id(), time_get_latch, endtime - starttime);
     starttime = endtime;
+#endif
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    // move fast readers into the retired list and keep appenders out
+    close_row();
+#endif
+#if BB_ADAPTIVE_RETIRE
+    contention = contention - (contention >> 3) +
+        ((waiter_cnt + retired_cnt + (owners ? 1 : 0)) << 1);
 #endif
     // timestamp
     ts_t ts = 0;
     ts_t owner_ts = 0;
     ts_t en_ts;
 #if !BB_DYNAMIC_TS
-    // [pre-assigned ts] assign ts if does not have one
-    if (ts == 0) {
-        txn->set_next_ts(1);
-        ts = txn->get_ts();
-    }
+    ts = txn->get_ts();
 #endif
     if (type == LOCK_SH) {
         // if read, decide if need to wait
@@ -183,6 +217,9 @@ RC Row_bamboo::lock_get(lock_t type, txn_man * txn, Access * access) {
             ADD_TO_RETIRED_TAIL(to_insert);
 #if PF_CS
             INC_STATS(txn->get_thd_id(), time_get_cs, get_sys_clock() - starttime);
+#endif
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+            open_row();
 #endif
             COMPILER_BARRIER
             unlock(txn);
@@ -195,10 +232,13 @@ RC Row_bamboo::lock_get(lock_t type, txn_man * txn, Access * access) {
         if (!retired_head && !owners) {
             owners = to_insert;
             owners->status = LOCK_OWNER;
-            owners->txn->lock_ready = true;
+            owners->txn->set_lock_ready();
             UPDATE_RETIRE_INFO(to_insert, retired_tail);
 #if PF_CS
             INC_STATS(txn->get_thd_id(), time_get_cs, get_sys_clock() - starttime);
+#endif
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+            open_row();
 #endif
             COMPILER_BARRIER
             unlock(txn);
@@ -275,6 +315,9 @@ final:
 #endif
 #if PF_CS
     INC_STATS(txn->get_thd_id(), time_get_cs, get_sys_clock() - starttime);
+#endif
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    open_row();
 #endif
     // release the latch
     COMPILER_BARRIER
@@ -291,6 +334,9 @@ RC Row_bamboo::lock_retire(BBLockEntry * entry) {
 #endif
     lock(entry->txn);
     COMPILER_BARRIER
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    close_row();
+#endif
 #if PF_CS
     uint64_t endtime = get_sys_clock();
     INC_STATS(entry->txn->get_thd_id(), time_retire_latch, endtime - starttime);
@@ -301,22 +347,21 @@ RC Row_bamboo::lock_retire(BBLockEntry * entry) {
     if (entry->status == LOCK_OWNER) {
         // move to retired list
         RETIRE_ENTRY(entry);
-        // make dirty data globally visible
-        if (entry->type == LOCK_EX) {
-#if PF_CS
-            uint64_t startt = get_sys_clock();
-            entry->access->orig_row->copy(entry->access->data);
-            INC_STATS(entry->txn->get_thd_id(), time_copy, get_sys_clock() - startt);
-#else
-            entry->access->orig_row->copy(entry->access->data);
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+        last_retired_wr = entry;
 #endif
-        }
+        // make dirty data globally visible
+        if (entry->type == LOCK_EX)
+            write_back(entry, true);
     } else {
         // may be is aborted: assert(txn->status == ABORTED);
         assert(entry->status == LOCK_DROPPED);
         rc = Abort;
     }
     bring_next(NULL);
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    open_row();
+#endif
 
 #if PF_CS
     INC_STATS(entry->txn->get_thd_id(), time_retire_cs, get_sys_clock() -
@@ -328,6 +373,11 @@ RC Row_bamboo::lock_retire(BBLockEntry * entry) {
 }
 
 RC Row_bamboo::lock_release(BBLockEntry * entry, RC rc) {
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    // a reader still in the bitmap leaves without the latch
+    if (entry->fast_row == this && fast_lock_release(entry))
+        return RCOK;
+#endif
 	if (entry->status == LOCK_DROPPED)
 	    return RCOK;
 #if PF_ABORT
@@ -338,6 +388,9 @@ RC Row_bamboo::lock_release(BBLockEntry * entry, RC rc) {
 #endif
     lock(entry->txn);
     COMPILER_BARRIER
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    close_row();
+#endif
 #if PF_CS
     uint64_t endtime = get_sys_clock();
     INC_STATS(entry->txn->get_thd_id(), time_release_latch, endtime- starttime);
@@ -349,15 +402,8 @@ RC Row_bamboo::lock_release(BBLockEntry * entry, RC rc) {
     } else if (entry->status == LOCK_OWNER) {
         owners = NULL;
         // not found in retired, need to make globally visible if rc = commit
-        if (rc == RCOK && (entry->type == LOCK_EX)) {
-#if PF_CS
-                uint64_t startt = get_sys_clock();
-                entry->access->orig_row->copy(entry->access->data);
-                INC_STATS(entry->txn->get_thd_id(), time_copy, get_sys_clock() - startt);
-#else
-                entry->access->orig_row->copy(entry->access->data);
-#endif
-        }
+        if (rc == RCOK && (entry->type == LOCK_EX))
+            write_back(entry, false);
     } else if (entry->status == LOCK_WAITER) {
 #if DEBUG_BAMBOO
 		UInt32 cnt = 0;
@@ -373,10 +419,10 @@ RC Row_bamboo::lock_release(BBLockEntry * entry, RC rc) {
 		assert(found);
 		assert(cnt == waiter_cnt);
 		assert(cnt != 0);
-        LIST_RM(waiters_head, waiters_tail, entry, waiter_cnt);
+        rm_from_waiters(entry);
 		assert(waiter_cnt == cnt-1);
 #else
-        LIST_RM(waiters_head, waiters_tail, entry, waiter_cnt);
+        rm_from_waiters(entry);
 #endif
     } else {
 		// already removed
@@ -388,6 +434,9 @@ RC Row_bamboo::lock_release(BBLockEntry * entry, RC rc) {
     assert(owners || retired_head || (waiter_cnt == 0));
     // WAIT - done releasing with is_abort = true
     // FINISH - done releasing with is_abort = false
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    open_row();
+#endif
 #if PF_CS
     INC_STATS(entry->txn->get_thd_id(), time_release_cs, get_sys_clock() -
   starttime);
@@ -405,6 +454,225 @@ RC Row_bamboo::lock_release(BBLockEntry * entry, RC rc) {
 }
 
 
+// install the writes of entry into the row. with retire = true others will
+// read them dirty, so keep what is needed to roll back.
+void Row_bamboo::write_back(BBLockEntry * entry, bool retire) {
+    Access * access = entry->access;
+#if PF_CS
+    uint64_t startt = get_sys_clock();
+#endif
+#if BB_UNDO_LOG
+    uint64_t cols = access->data->wr_cols;
+    if (retire) {
+        access->orig_data->copy_cols(_row, cols);
+#if PF_CS
+        uint64_t endt = get_sys_clock();
+        INC_STATS(entry->txn->get_thd_id(), time_copy_undo, endt - startt);
+        startt = endt;
+#endif
+    }
+    _row->copy_cols(access->data, cols);
+#else
+    _row->copy(access->data);
+#endif
+#if PF_CS
+    INC_STATS(entry->txn->get_thd_id(), time_copy, get_sys_clock() - startt);
+#endif
+}
+
+// a reader ordered before writer reads the row as it was before the write
+void Row_bamboo::read_before_image(BBLockEntry * reader, BBLockEntry * writer) {
+    row_t * data = reader->access->data;
+#if PF_CS
+    uint64_t startt = get_sys_clock();
+#endif
+    if (writer->status == LOCK_OWNER) {
+        // not retired yet, the row itself is the before image
+#if BB_ADAPTIVE_RETIRE || BB_UNDO_LOG
+        data->copy(_row);
+#else
+        data->copy(writer->access->orig_data);
+#endif
+    } else {
+#if BB_UNDO_LOG
+        // undo the retired writes from the tail back to writer
+        data->copy(_row);
+        for (BBLockEntry * en = retired_tail; en; en = en->prev) {
+            if (en->type == LOCK_EX)
+                data->copy_cols(en->access->orig_data, en->access->data->wr_cols);
+            if (en == writer)
+                break;
+        }
+#else
+        data->copy(writer->access->orig_data);
+#endif
+    }
+#if PF_CS
+    INC_STATS(reader->txn->get_thd_id(), time_copy, get_sys_clock() - startt);
+#endif
+}
+
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+// Fast path for readers: while no writer has touched the row, the lists are
+// empty and every reader is a cohead with nothing to wait for, so joining
+// is a single CAS that sets the reader's bit. The entry is filled in before
+// the CAS so that a writer closing the row can move it into the lists.
+bool Row_bamboo::fast_lock_get(BBLockEntry * to_insert) {
+    uint64_t thd_id = to_insert->txn->get_thd_id();
+    if (unlikely(thd_id >= BB_FP_MAX_THD))
+        return false;
+    uint64_t bit = 1UL << thd_id;
+    uint64_t word = fast_readers;
+    // closed, or the txn reads the row twice
+    if (word & (BB_FP_CLOSED | bit))
+        return false;
+    to_insert->is_cohead = true;
+    to_insert->status = LOCK_RETIRED;
+    to_insert->fast_row = this;
+    COMPILER_BARRIER
+    while (!ATOM_CAS(fast_readers, word, word | bit)) {
+        word = fast_readers;
+        if (word & BB_FP_CLOSED)
+            break;
+    }
+    if (word & BB_FP_CLOSED) {
+        to_insert->is_cohead = false;
+        to_insert->status = LOCK_DROPPED;
+        to_insert->fast_row = NULL;
+        return false;
+    }
+    return true;
+}
+
+// returns false if the row has been closed in the meantime, in which case
+// the entry has been moved into the retired list under the latch.
+bool Row_bamboo::fast_lock_release(BBLockEntry * entry) {
+    uint64_t bit = 1UL << entry->txn->get_thd_id();
+    uint64_t word = fast_readers;
+    while (!(word & BB_FP_CLOSED)) {
+        if (ATOM_CAS(fast_readers, word, word & ~bit)) {
+            return_entry(entry);
+            entry->fast_row = NULL;
+            return true;
+        }
+        word = fast_readers;
+    }
+    return false;
+}
+
+// A reader that goes to the retired tail of a closed row appends itself
+// without the latch: with no owner and no waiter, and a ts larger than any
+// retired writer's, the latched path would do the same append. Latched ops
+// set BB_FP_HOLD and wait out the appenders, so the lists, owners and
+// last_retired_wr do not change while an appender is registered.
+bool Row_bamboo::append_lock_get(BBLockEntry * to_insert) {
+    uint64_t word = fast_readers;
+    while (true) {
+        if ((word & (BB_FP_CLOSED | BB_FP_HOLD)) != BB_FP_CLOSED)
+            return false;
+        if (ATOM_CAS(fast_readers, word, word + 1))
+            break;
+        word = fast_readers;
+    }
+    bool appended = false;
+    if (!owners && !waiters_head) {
+        BBLockEntry * wr = last_retired_wr;
+        if (wr) {
+            txn_man * txn = to_insert->txn;
+#if BB_DYNAMIC_TS
+            // [W][R] everybody behind a retired write has a ts
+            assign_ts(0, wr->txn);
+            ts_t ts = assign_ts(txn->get_ts(), txn);
+#else
+            ts_t ts = txn->get_ts();
+#endif
+            // otherwise read the before image of wr, under the latch
+            appended = a_higher_than_b(wr->txn->get_ts(), ts);
+        } else
+            appended = true;
+        if (appended)
+            append_to_retired_tail(to_insert);
+    }
+    ATOM_SUB(fast_readers, 1);
+    return appended;
+}
+
+// UPDATE_RETIRE_INFO and ADD_TO_RETIRED_TAIL with concurrent appenders.
+// prev cannot leave while we are registered, but may still be an appender
+// that has not decided whether it is a cohead. Both sides publish first
+// (is_cohead, or the link to prev) and then look at the other.
+void Row_bamboo::append_to_retired_tail(BBLockEntry * to_insert) {
+    to_insert->next = NULL;
+    to_insert->is_cohead = false;
+    to_insert->status = LOCK_RETIRED;
+    BBLockEntry * prev = __sync_lock_test_and_set(&retired_tail, to_insert);
+    to_insert->prev = prev;
+    ATOM_ADD(retired_cnt, 1);
+    if (!prev) {
+        to_insert->is_cohead = true;
+        retired_head = to_insert;
+    } else if (prev->type == LOCK_SH && prev->is_cohead) {
+        // only latched ops take a cohead away
+        to_insert->is_cohead = true;
+        prev->next = to_insert;
+    } else {
+        to_insert->txn->increment_commit_barriers();
+        prev->next = to_insert;
+        __sync_synchronize();
+        // prev became a cohead after we looked, whoever did it may have
+        // missed the link
+        if (prev->type == LOCK_SH && prev->is_cohead &&
+            ATOM_CAS(to_insert->is_cohead, false, true))
+            to_insert->txn->decrement_commit_barriers();
+        else
+            return;
+    }
+    __sync_synchronize();
+    pass_cohead(to_insert);
+}
+
+// must hold the latch. closes the reader bitmap and moves its readers into
+// the retired list, or waits out the readers still appending. The lists
+// stay put until open_row().
+void Row_bamboo::close_row() {
+    uint64_t readers = __sync_fetch_and_or(&fast_readers,
+                                           BB_FP_CLOSED | BB_FP_HOLD);
+    if (readers & BB_FP_CLOSED) {
+        // appenders never wait, this is short
+        while (fast_readers & BB_FP_APPENDERS)
+            PAUSE
+        COMPILER_BARRIER
+        return;
+    }
+    assert(!owners && !retired_head && !waiters_head);
+    while (readers) {
+        uint64_t thd_id = __builtin_ctzl(readers);
+        readers &= readers - 1;
+        materialize_reader(glob_manager->get_txn_man(thd_id));
+    }
+    fast_readers = BB_FP_CLOSED | BB_FP_HOLD;
+}
+
+// find the entry the reader published in fast_lock_get and append it to the
+// retired list as a cohead, which is where the latched path puts it.
+void Row_bamboo::materialize_reader(txn_man * txn) {
+    for (int i = 0; i < txn->num_accesses_alloc; i++) {
+        BBLockEntry * en = txn->accesses[i]->lock_entry;
+        if (en->fast_row != this)
+            continue;
+        assert(en->type == LOCK_SH && en->status == LOCK_RETIRED);
+        en->fast_row = NULL;
+        en->next = NULL;
+        en->prev = NULL;
+        en->is_cohead = true;
+        LIST_PUT_TAIL(retired_head, retired_tail, en);
+        retired_cnt++;
+        return;
+    }
+    assert(false);
+}
+#endif
+
 inline
 bool Row_bamboo::bring_next(txn_man * txn) {
 #if DEBUG_BAMBOO
@@ -457,9 +725,20 @@ bool Row_bamboo::bring_next(txn_man * txn) {
 // descendants if is_abort = true)
 inline
 BBLockEntry * Row_bamboo::rm_from_retired(BBLockEntry * en, bool is_abort, txn_man * txn) {
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    // an abort also takes every entry behind en
+    if (en->type == LOCK_EX && (is_abort || en == last_retired_wr))
+        last_retired_wr = writer_before(en);
+#endif
     if (is_abort && (en->type == LOCK_EX)) {
+#if PF_CS
+        uint64_t startt = get_sys_clock();
+        CHECK_ROLL_BACK(en); // roll back only for the first-conflicting-write
+        INC_STATS(txn->get_thd_id(), time_copy_undo, get_sys_clock() - startt);
+#else
         CHECK_ROLL_BACK(en); // roll back only for the first-conflicting-write
-        en->txn->lock_abort = true;
+#endif
+        en->txn->set_lock_abort();
         en = remove_descendants(en, txn);
         return en;
     } else {
@@ -565,9 +844,19 @@ txn) {
     assert(en->type == LOCK_EX);
     BBLockEntry * prev = en->prev;
     BBLockEntry * to_return;
+#if PF_ABORT_GRAPH
+    // en is the aborted writer, everything behind it read its dirty data
+    txn_man * wounder = en->txn;
+    uint64_t depth = 0;
+#endif
     // abort till end, no need to update barrier as set abort anyway
     LIST_RM_SINCE(retired_head, retired_tail, en);
     while(en) {
+#if PF_ABORT_GRAPH
+        if (depth > 0)
+            RECORD_ABORT_EDGE(txn, wounder, en->txn, depth);
+        depth++;
+#endif
         en->txn->set_abort(true);
         to_return = en;
         if (retired_cnt == 0)
@@ -583,6 +872,9 @@ txn) {
     if (owners) {
 #if PF_ABORT
         txn->abort_chain++;
+#endif
+#if PF_ABORT_GRAPH
+        RECORD_ABORT_EDGE(txn, wounder, owners->txn, depth);
 #endif
         owners->txn->set_abort();
         return_entry(owners);
@@ -604,6 +896,16 @@ RC Row_bamboo::insert_read_to_retired(BBLockEntry * to_insert, ts_t ts,
     // TODO: handle case if en is committed.
 	for (UInt32 i = 0; i < retired_cnt; i++) {
 		if ((en->type == LOCK_EX) && (en->txn->get_ts() > ts)) {
+#if BB_BATCH_BARRIER
+            // a non-cohead holds a barrier from this row and cannot commit
+            // while the latch is held, no need to pin it.
+            if (!en->is_cohead) {
+                if ((en->txn->commit_barriers & 3UL) == RUNNING)
+                    break;
+                en = en->next;
+                continue;
+            }
+#endif
             // increment barrier anyway. if is not cohead, decrement the barrier
             en->txn->increment_commit_barriers();
             // compiler barrier
@@ -627,14 +929,8 @@ RC Row_bamboo::insert_read_to_retired(BBLockEntry * to_insert, ts_t ts,
         LIST_INSERT_BEFORE_CH(retired_head, en, to_insert);
         to_insert->status = LOCK_RETIRED;
         retired_cnt++;
-		to_insert->txn->lock_ready = true;
-#if PF_CS
-        uint64_t startt = get_sys_clock();
-        access->data->copy(en->access->orig_data);
-        INC_STATS(to_insert->txn->get_thd_id(), time_copy, get_sys_clock() - startt);
-#else
-        access->data->copy(en->access->orig_data);
-#endif
+		to_insert->txn->set_lock_ready();
+        read_before_image(to_insert, en);
 		rc = FINISH;
 #if DBEUG_BAMBOO
         check_correctness();
@@ -643,25 +939,28 @@ RC Row_bamboo::insert_read_to_retired(BBLockEntry * to_insert, ts_t ts,
 		if (owners) {
             // insert before owners.
             assert(ts != 0);
+#if BB_BATCH_BARRIER
+            if (owners->is_cohead)
+                owners->txn->increment_commit_barriers();
+#else
             owners->txn->increment_commit_barriers();
+#endif
             COMPILER_BARRIER
             if ((owners->txn->commit_barriers & 3UL) == RUNNING) {
+#if BB_BATCH_BARRIER
+                owners->is_cohead = false;
+#else
                 if (!owners->is_cohead)
                     owners->txn->decrement_commit_barriers();
                 else
                     owners->is_cohead = false;
+#endif
                 UPDATE_RETIRE_INFO(to_insert, retired_tail);
                 LIST_PUT_TAIL(retired_head, retired_tail, to_insert);
                 to_insert->status = LOCK_RETIRED;
                 retired_cnt++;
-#if PF_CS
-                uint64_t startt = get_sys_clock();
-                access->data->copy(owners->access->orig_data);
-                INC_STATS(to_insert->txn->get_thd_id(), time_copy, get_sys_clock() - startt);
-#else
-                access->data->copy(owners->access->orig_data);
-#endif
-                to_insert->txn->lock_ready = true;
+                read_before_image(to_insert, owners);
+                to_insert->txn->set_lock_ready();
                 rc = FINISH;
                 assert((owners->txn->commit_barriers & 3UL) != COMMITED);
             } else {
@@ -678,7 +977,7 @@ RC Row_bamboo::insert_read_to_retired(BBLockEntry * to_insert, ts_t ts,
 		    } else {
 		        UPDATE_RETIRE_INFO(to_insert, retired_tail);
 				ADD_TO_RETIRED_TAIL(to_insert);
-				to_insert->txn->lock_ready = true;
+				to_insert->txn->set_lock_ready();
 				rc = RCOK;
 		    }
 #else
@@ -690,14 +989,14 @@ RC Row_bamboo::insert_read_to_retired(BBLockEntry * to_insert, ts_t ts,
 			} else {
 				UPDATE_RETIRE_INFO(to_insert, retired_tail);
 				ADD_TO_RETIRED_TAIL(to_insert);
-				to_insert->txn->lock_ready = true;
+				to_insert->txn->set_lock_ready();
 				rc = RCOK;
 			}
 #endif
 #else
             UPDATE_RETIRE_INFO(to_insert, retired_tail);
             ADD_TO_RETIRED_TAIL(to_insert);
-            to_insert->txn->lock_ready = true;
+            to_insert->txn->set_lock_ready();
             rc = RCOK;
 #endif
 		}
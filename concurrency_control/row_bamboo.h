@@ -69,9 +69,23 @@
   to_retire->prev=NULL; \
   ADD_TO_RETIRED_TAIL(to_retire); }
 
+#if BB_UNDO_LOG
+// orig_data only holds the before image of the columns a writer changed,
+// so undo every retired write from the tail back to en (all get aborted)
+#define CHECK_ROLL_BACK(en) { \
+    for (BBLockEntry * u = retired_tail; u; u = u->prev) { \
+        if (u->type == LOCK_EX) \
+            u->access->orig_row->copy_cols(u->access->orig_data, \
+                u->access->data->wr_cols); \
+        if (u == en) \
+            break; \
+    } \
+}
+#else
 #define CHECK_ROLL_BACK(en) { \
     en->access->orig_row->copy(en->access->orig_data); \
 }
+#endif
 
 #define DEC_BARRIER_PF(entry) { \
     assert(!entry->is_cohead); \
@@ -88,6 +102,17 @@
     entry->txn->decrement_commit_barriers(); \
 }
 
+#if PF_ABORT_GRAPH
+#define RECORD_ABORT_EDGE(thd_txn, wounder, victim, depth) \
+    stats.add_abort_edge(thd_txn->get_thd_id(), wounder->get_txn_id(), \
+        victim->get_txn_id(), _row->get_primary_key(), \
+        _row->get_table_name(), depth);
+#else
+#define RECORD_ABORT_EDGE(thd_txn, wounder, victim, depth)
+#endif
+
+class Row_bamboo;
+
 struct BBLockEntry {
     // type of lock: EX or SH
     txn_man * txn;
@@ -100,18 +125,47 @@ struct BBLockEntry {
     bool is_cohead;
     lock_status status;
     BBLockEntry * prev;
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    // row whose reader bitmap holds this entry, NULL once it is in the lists
+    Row_bamboo * fast_row;
+#endif
+#if BB_WAITER_SKIPLIST
+    // ts the entry waits with, and its links in the upper waiter levels
+    ts_t wait_ts;
+    int height;
+    BBLockEntry * skip_next[BB_WAITER_LEVELS - 1];
+#endif
     BBLockEntry(txn_man * t, Access * a): txn(t), access(a), type(LOCK_NONE),
                                           next(NULL), is_cohead(false),
                                           status(LOCK_DROPPED),
-                                          prev(NULL) {};
+                                          prev(NULL)
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+                                          , fast_row(NULL)
+#endif
+                                          {};
 };
 
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+// fast_readers layout: bit i is set if thread i holds a read lock without
+// an entry in the lists. BB_FP_CLOSED is set while the lists are in use,
+// then the low bits count readers appending to the retired tail without the
+// latch, and BB_FP_HOLD keeps new ones out while a latched op runs.
+#define BB_FP_CLOSED        (1UL << 63)
+#define BB_FP_HOLD          (1UL << 62)
+#define BB_FP_APPENDERS     (BB_FP_HOLD - 1)
+#define BB_FP_MAX_THD       62
+#endif
+
 class Row_bamboo {
   public:
     void init(row_t * row);
     RC lock_get(lock_t type, txn_man * txn, Access * access);
     RC lock_release(BBLockEntry * entry, RC rc);
     RC lock_retire(BBLockEntry * entry);
+#if BB_ADAPTIVE_RETIRE
+    // read without the latch, only a hint
+    bool is_hot() { return contention >= (BB_HOT_THRESHOLD << 4); };
+#endif
 
   private:
     // data structure
@@ -120,9 +174,23 @@ class Row_bamboo {
     BBLockEntry * retired_tail;
     BBLockEntry * waiters_head;
     BBLockEntry * waiters_tail;
+#if BB_WAITER_SKIPLIST
+    // upper levels of the waiter list, level 0 is waiters_head itself
+    BBLockEntry * skip_head[BB_WAITER_LEVELS - 1];
+#endif
     row_t * _row;
     UInt32 waiter_cnt;
     UInt32 retired_cnt;
+#if BB_ADAPTIVE_RETIRE
+    // ewma (1/8) of entries found on the row by lock_get, scaled by 16
+    UInt32 contention;
+#endif
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    volatile uint64_t fast_readers;
+    // last LOCK_EX in the retired list, readers append behind it only if
+    // they have a larger ts. only changed under the latch.
+    BBLockEntry * last_retired_wr;
+#endif
     // latches
 #if LATCH == LH_SPINLOCK
     pthread_spinlock_t * latch;
@@ -141,6 +209,40 @@ class Row_bamboo {
     void              lock(txn_man * txn);
     void              unlock(txn_man * txn);
 	RC                insert_read_to_retired(BBLockEntry * to_insert, ts_t ts, Access * access);
+    void              write_back(BBLockEntry * entry, bool retire);
+    void              read_before_image(BBLockEntry * reader, BBLockEntry * writer);
+#if BB_LOCK_TABLE == BB_LT_ATOMIC
+    bool              fast_lock_get(BBLockEntry * to_insert);
+    bool              fast_lock_release(BBLockEntry * entry);
+    bool              append_lock_get(BBLockEntry * to_insert);
+    void              append_to_retired_tail(BBLockEntry * to_insert);
+    void              close_row();
+    void              materialize_reader(txn_man * txn);
+    // must hold the latch. lets appenders back in, or hands the row back to
+    // fast readers once the lists are drained. nobody else writes
+    // fast_readers while BB_FP_HOLD is set.
+    inline void       open_row() {
+        COMPILER_BARRIER
+        if (!owners && !retired_head && !waiters_head)
+            fast_readers = 0;
+        else
+            fast_readers = BB_FP_CLOSED;
+    };
+    // en became a cohead, readers linked behind it become coheads too.
+    // whoever sets a reader's is_cohead passes it on, the CAS makes sure
+    // each barrier is returned once.
+    inline void       pass_cohead(BBLockEntry * en) {
+        for (en = en->next; en && en->type == LOCK_SH; en = en->next) {
+            if (!ATOM_CAS(en->is_cohead, false, true))
+                break;
+            en->txn->decrement_commit_barriers();
+        }
+    };
+    inline static BBLockEntry * writer_before(BBLockEntry * en) {
+        for (en = en->prev; en && en->type != LOCK_EX; en = en->prev) {}
+        return en;
+    };
+#endif
 #if DEBUG_BAMBOO
 	void              check_correctness();
 #endif
@@ -171,6 +273,9 @@ class Row_bamboo {
         entry->prev = NULL;
         entry->status = LOCK_DROPPED;
         entry->is_cohead = false;
+      #if BB_LOCK_TABLE == BB_LT_ATOMIC
+        entry->fast_row = NULL;
+      #endif
         return entry;
     #else
         return NULL;
@@ -185,22 +290,89 @@ class Row_bamboo {
         entry->status = LOCK_DROPPED;
     };
 
-	inline bool bring_out_waiter(BBLockEntry * entry, txn_man * txn) {
+	inline void rm_from_waiters(BBLockEntry * entry) {
+#if BB_WAITER_SKIPLIST
+		skip_remove(entry);
+#endif
 		LIST_RM(waiters_head, waiters_tail, entry, waiter_cnt);
-		entry->txn->lock_ready = true;
+	};
+
+	inline bool bring_out_waiter(BBLockEntry * entry, txn_man * txn) {
+		rm_from_waiters(entry);
+		entry->txn->set_lock_ready();
 		if (txn == entry->txn) {
 			return true;
 		}
 		return false;
 	};
 
+#if BB_WAITER_SKIPLIST
+#define SKIP_NEXT(en, lvl) ((en)? (en)->skip_next[lvl] : skip_head[lvl])
+	// link to_insert into the upper levels and return the first waiter with
+	// a larger ts (to_insert goes right before it in the waiter list)
+	inline BBLockEntry * skip_insert(ts_t ts, BBLockEntry * to_insert) {
+		uint64_t h = (ts * 0x9E3779B97F4A7C15UL) >> 32;
+		to_insert->height = __builtin_ctzl(h | (1UL << (BB_WAITER_LEVELS - 1)));
+		to_insert->wait_ts = ts;
+		BBLockEntry * pred = NULL;
+		for (int lvl = BB_WAITER_LEVELS - 2; lvl >= 0; lvl--) {
+			BBLockEntry * next = SKIP_NEXT(pred, lvl);
+			while (next && next->wait_ts <= ts) {
+				pred = next;
+				next = next->skip_next[lvl];
+			}
+			if (lvl < to_insert->height) {
+				to_insert->skip_next[lvl] = next;
+				if (pred)
+					pred->skip_next[lvl] = to_insert;
+				else
+					skip_head[lvl] = to_insert;
+			}
+		}
+		BBLockEntry * en = pred? pred->next : waiters_head;
+		while (en && en->wait_ts <= ts)
+			en = en->next;
+		return en;
+	};
+
+	// O(1) for the head, which is what bring_next removes
+	inline void skip_remove(BBLockEntry * entry) {
+		BBLockEntry * pred = NULL;
+		for (int lvl = BB_WAITER_LEVELS - 2; lvl >= 0; lvl--) {
+			BBLockEntry * next = SKIP_NEXT(pred, lvl);
+			if (lvl >= entry->height) {
+				// stop before waiters with the same ts, entry may be any of them
+				while (next && next->wait_ts < entry->wait_ts) {
+					pred = next;
+					next = next->skip_next[lvl];
+				}
+			} else {
+				while (next != entry) {
+					pred = next;
+					next = next->skip_next[lvl];
+				}
+				if (pred)
+					pred->skip_next[lvl] = entry->skip_next[lvl];
+				else
+					skip_head[lvl] = entry->skip_next[lvl];
+			}
+		}
+	};
+#endif
+
 	inline void add_to_waiters(ts_t ts, BBLockEntry * to_insert) {
+		INC_STATS(to_insert->txn->get_thd_id(), waiter_len, waiter_cnt);
+		INC_STATS(to_insert->txn->get_thd_id(), waiter_insert_cnt, 1);
+#if BB_WAITER_SKIPLIST
+		BBLockEntry * en = skip_insert(ts, to_insert);
+#else
 		BBLockEntry * en = waiters_head;
 		while (en != NULL) {
 			if (ts < en->txn->get_ts())
 					break;
 			en = en->next;
 		}
+#endif
 		if (en) {
 			LIST_INSERT_BEFORE(en, to_insert);
 			if (en == waiters_head)
@@ -227,6 +399,7 @@ class Row_bamboo {
                     en = en->next;
                     continue;
 				}
+				RECORD_ABORT_EDGE(to_insert->txn, to_insert->txn, en->txn, 0);
 				en = rm_from_retired(en, true, to_insert->txn);
 			} else
 				en = en->next;
@@ -245,6 +418,7 @@ class Row_bamboo {
                     en = en->next;
                     continue;
 				}
+				RECORD_ABORT_EDGE(to_insert->txn, to_insert->txn, en->txn, 0);
 				en = rm_from_retired(en, true, to_insert->txn);
 			} else
 				en = en->next;
@@ -258,6 +432,7 @@ class Row_bamboo {
 			//return Abort;
             return WAIT;
 		}
+		RECORD_ABORT_EDGE(to_insert->txn, to_insert->txn, owners->txn, 0);
 		return_entry(owners);
 		owners = NULL;
 		return RCOK;
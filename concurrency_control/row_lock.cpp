@@ -23,6 +23,9 @@ void Row_lock::init(row_t * row) {
 #endif
   lock_type = LOCK_NONE;
   blatch = false;
+#if CC_ALG == NO_WAIT
+  lock_word = 0;
+#endif
 
 }
 
@@ -73,6 +76,25 @@ RC Row_lock::lock_get(lock_t type, txn_man * txn, uint64_t* &txnids,
   int part_id =_row->get_part_id();
 
   LockEntry * entry = get_entry(access);
+#if CC_ALG == NO_WAIT
+  // any conflict aborts, nothing to queue
+  if (type == LOCK_EX) {
+    if (lock_word != 0 || !ATOM_CAS(lock_word, 0, LW_WR))
+      return Abort;
+  } else {
+    uint64_t w;
+    do {
+      w = lock_word;
+      if (w & LW_WR)
+        return Abort;
+    } while (!ATOM_CAS(lock_word, w, w + 1));
+  }
+  entry->type = type;
+  entry->txn = txn;
+  entry->status = LOCK_OWNER;
+  txn->lock_ready = true;
+  return RCOK;
+#endif
 
 #if PF_CS
   uint64_t starttime = get_sys_clock();
@@ -180,7 +202,7 @@ RC Row_lock::lock_get(lock_t type, txn_man * txn, uint64_t* &txnids,
     entry->type = type;
     entry->txn = txn;
     txn->lock_ready = true;
-    STACK_PUSH(owners, entry);
+    owner_push(entry);
     entry->status = LOCK_OWNER;
     owner_cnt ++;
     lock_type = type;
@@ -222,6 +244,14 @@ RC Row_lock::lock_get(lock_t type, txn_man * txn, uint64_t* &txnids,
 
 
 RC Row_lock::lock_release(LockEntry * entry) {
+#if CC_ALG == NO_WAIT
+  assert(entry->status == LOCK_OWNER);
+  if (entry->type == LOCK_EX)
+    ATOM_SUB(lock_word, LW_WR);
+  else
+    ATOM_SUB(lock_word, 1);
+  return RCOK;
+#endif
 #if PF_CS
   uint64_t starttime = get_sys_clock();
 #endif
@@ -234,19 +264,10 @@ RC Row_lock::lock_release(LockEntry * entry) {
 #endif
   LockEntry * en;
   // Try to find the entry in the owners
-  if (entry->status == LOCK_OWNER) { // find the entry in the owner list
-    en = owners;
-    LockEntry * prev = NULL;
-    while(en) {
-      if (en == entry)
-        break;
-      prev = en;
-      en = en->next;
-    }
+  if (entry->status == LOCK_OWNER) {
     // rm from owners
-    if (prev)
-      prev->next = entry->next;
-    else
+    LIST_REMOVE(entry);
+    if (entry == owners)
       owners = entry->next;
     owner_cnt --;
     if (owner_cnt == 0)
@@ -272,12 +293,12 @@ RC Row_lock::lock_release(LockEntry * entry) {
   // If any waiter can join the owners, just do it!
   while (waiters_head && !conflict_lock(lock_type, waiters_head->type)) {
     LIST_GET_HEAD(waiters_head, waiters_tail, en);
-    STACK_PUSH(owners, en);
+    owner_push(en);
     en->status = LOCK_OWNER;
     owner_cnt ++;
     waiter_cnt --;
     ASSERT(en->txn->lock_ready == false);
-    en->txn->lock_ready = true;
+    en->txn->set_lock_ready();
     lock_type = en->type;
     //printf("[%p]txn-%lu got %lu\n", en, en->txn->get_txn_id(), _row->get_row_id());
   }
@@ -291,6 +312,15 @@ RC Row_lock::lock_release(LockEntry * entry) {
   return RCOK;
 }
 
+inline
+void Row_lock::owner_push(LockEntry * entry) {
+  entry->prev = NULL;
+  entry->next = owners;
+  if (owners)
+    owners->prev = entry;
+  owners = entry;
+}
+
 bool Row_lock::conflict_lock(lock_t l1, lock_t l2) {
   if (l1 == LOCK_NONE || l2 == LOCK_NONE)
     return false;
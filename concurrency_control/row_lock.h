@@ -12,6 +12,12 @@ struct LockEntry {
                                         status(LOCK_DROPPED), next(NULL), prev(NULL) {};
 };
 
+#if CC_ALG == NO_WAIT
+// [NO_WAIT] a txn never waits, so the lock is a single word of the EX bit
+// or the # of SH holders. No owner/waiter list and no latch on the row.
+#define LW_WR (1UL << 63)
+#endif
+
 class Row_lock {
   public:
     void init(row_t * row);
@@ -35,12 +41,16 @@ class Row_lock {
     bool 		conflict_lock(lock_t l1, lock_t l2);
     static LockEntry * get_entry(Access * access);
     static void 		return_entry(LockEntry * entry);
+    void        owner_push(LockEntry * entry);
     row_t * _row;
     lock_t lock_type;
     UInt32 owner_cnt;
     UInt32 waiter_cnt;
 
-    // owners is a single linked list
+#if CC_ALG == NO_WAIT
+    uint64_t volatile lock_word;
+#endif
+    // owners is a double linked list, so a release unlinks in O(1)
     // waiters is a double linked list
     // [waiters] head is the oldest txn, tail is the youngest txn.
     //   So new txns are inserted into the tail.
@@ -3,28 +3,101 @@
 #include "row_ol.h"
 #include "mem_alloc.h"
 
+// every lock is taken in rank order, so a waiter only ever waits for txns
+// that make progress. Spin, and give the core away now and then unless the
+// run is pure spinning.
+static inline void
+ol_relax(UInt32 & spins) {
+    PAUSE
+#if WAIT_STRATEGY != WAIT_SPIN
+    if (++spins % WAIT_SPIN_CNT == 0)
+        sched_yield();
+#endif
+}
+
 void
 Row_ol::init(row_t * row) {
-	_row = row;
+#if OL_LOCK == OL_PTHREAD
     pthread_rwlock_init(&_lock, NULL);
-    // rank, just use pointer addr for now..
-    rank = (uint64_t)&_lock;
+#elif OL_LOCK == OL_RWSPIN
+    _lock = 0;
+#elif OL_LOCK == OL_PFTICKET
+    _rin = _rout = _win = _wout = 0;
+#endif
+    (void)row;
 }
 
 void
 Row_ol::lock(access_t acc) {
+    assert(acc == WR || acc == RD);
+    UInt32 spins = 0;
+#if OL_LOCK == OL_PTHREAD
     if (acc == WR) {
         pthread_rwlock_wrlock(&_lock);
-    } else if (acc == RD) {
+    } else {
         pthread_rwlock_rdlock(&_lock);
+    }
+#elif OL_LOCK == OL_RWSPIN
+    if (acc == WR) {
+        while (true) {
+            uint64_t w = _lock;
+            if ((w & ~OL_WW) == 0) {
+                // clears OL_WW, the other waiting writers set it again
+                if (ATOM_CAS(_lock, w, OL_WR))
+                    break;
+            } else if (!(w & OL_WW)) {
+                ATOM_CAS(_lock, w, w | OL_WW);
+            }
+            ol_relax(spins);
+        }
     } else {
-        assert(0);
+        while (true) {
+            uint64_t w = _lock;
+            if (!(w & (OL_WR | OL_WW)) && ATOM_CAS(_lock, w, w + 1))
+                break;
+            ol_relax(spins);
+        }
     }
+#elif OL_LOCK == OL_PFTICKET
+    if (acc == WR) {
+        // wait for the writers ahead, then for the readers of this phase
+        uint32_t ticket = ATOM_FETCH_ADD(_win, 1);
+        while (_wout != ticket)
+            ol_relax(spins);
+        uint32_t w = OL_PRES | (ticket & OL_PHID);
+        uint32_t rticket = ATOM_FETCH_ADD(_rin, w);
+        while (_rout != rticket)
+            ol_relax(spins);
+    } else {
+        // a reader waits for at most one writer phase
+        uint32_t w = ATOM_FETCH_ADD(_rin, OL_RINC) & OL_WBITS;
+        if (w != 0) {
+            while ((_rin & OL_WBITS) == w)
+                ol_relax(spins);
+        }
+    }
+#endif
     return;
 }
 
 void
 Row_ol::unlock(access_t acc) {
+#if OL_LOCK == OL_PTHREAD
     pthread_rwlock_unlock(&_lock);
+#elif OL_LOCK == OL_RWSPIN
+    // OL_WW may have been set meanwhile, so subtract
+    if (acc == WR)
+        ATOM_SUB(_lock, OL_WR);
+    else
+        ATOM_SUB(_lock, 1);
+#elif OL_LOCK == OL_PFTICKET
+    if (acc == WR) {
+        __sync_fetch_and_and(&_rin, ~(uint32_t)OL_WBITS);
+        COMPILER_BARRIER
+        _wout = _wout + 1;
+    } else {
+        ATOM_ADD(_rout, OL_RINC);
+    }
+#endif
     (void)acc;
 }
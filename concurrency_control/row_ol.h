@@ -4,16 +4,41 @@
 class table_t;
 class txn_man;
 
+// rows are locked in the order of their rank, a (table, key) pair that the
+// txn knows without touching the row. Keys must stay below 2^56, a larger
+// one would spill into the table bits and break the lock order.
+#define OL_RANK(table, key) (assert((uint64_t)(key) < (1UL << 56)), \
+    ((uint64_t)(table) << 56) | (key))
+
+#if OL_LOCK == OL_RWSPIN
+#define OL_WR               (1UL << 63) // held by a writer
+#define OL_WW               (1UL << 62) // a writer waits, readers back off
+#elif OL_LOCK == OL_PFTICKET
+#define OL_RINC             0x100 // readers count in the upper 24 bits
+#define OL_WBITS            0x3
+#define OL_PRES             0x2   // a writer is present
+#define OL_PHID             0x1   // and the phase it is in
+#endif
+
 class Row_ol {
 public:
 	void 				init(row_t * row);
     // simple locks, and always non-blocking
     void                lock(access_t acc);
     void                unlock(access_t acc);
-    uint64_t            rank;
 private:
-	row_t * 			_row;
+#if OL_LOCK == OL_PTHREAD
     pthread_rwlock_t    _lock;
+#elif OL_LOCK == OL_RWSPIN
+    // OL_WR | OL_WW | number of readers
+    volatile uint64_t   _lock;
+#elif OL_LOCK == OL_PFTICKET
+    // readers in/out, writer tickets in/out
+    volatile uint32_t   _rin;
+    volatile uint32_t   _rout;
+    volatile uint32_t   _win;
+    volatile uint32_t   _wout;
+#endif
 };
 
 #endif
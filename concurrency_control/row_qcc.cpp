@@ -11,8 +11,8 @@ Row_qcc::init(row_t * row) {
 }
 
 void
-Row_qcc::write(row_t * data) {
-	_row->copy(data);
+Row_qcc::write(uint64_t pos, const char * src, uint64_t len) {
+	memcpy(&_row->get_data()[pos], src, len);
 }
 
 #endif
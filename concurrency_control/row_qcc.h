@@ -7,7 +7,7 @@ class txn_man;
 class Row_qcc {
 public:
 	void 				init(row_t * row);
-	void				write(row_t * data);
+	void				write(uint64_t pos, const char * src, uint64_t len);
 private:
 	row_t * 			_row;
 };
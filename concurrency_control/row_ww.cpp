@@ -283,7 +283,7 @@ Row_ww::bring_next() {
     owner_cnt ++;
     waiter_cnt --;
     ASSERT(entry->txn->lock_ready == 0);
-    entry->txn->lock_ready = true;
+    entry->txn->set_lock_ready();
     lock_type = entry->type;
   }
   ASSERT((owners == NULL) == (owner_cnt == 0));
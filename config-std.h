@@ -45,6 +45,13 @@
 
 // latch options
 #define LATCH					    LH_SPINLOCK
+// how a blocked txn waits for lock_ready/lock_abort (WAIT_DIE, WOUND_WAIT,
+// BAMBOO): spin, spin then sleep on a futex, or spin then back off
+#define WAIT_STRATEGY               WAIT_SPIN
+#define WAIT_SPIN_CNT               1000
+#define WAIT_FUTEX_TIMEOUT          100000 // 100 us, bounds a lost wakeup
+// max pauses per backoff round, or tsc cycles per umwait with waitpkg
+#define WAIT_BACKOFF_MAX            1024
 
 // all transactions acquire tuples according to the primary key order.
 #define KEY_ORDER					false
@@ -61,6 +68,10 @@
 #define CENTRAL_INDEX				false
 #define CENTRAL_MANAGER 			false
 #define INDEX_STRUCT				IDX_HASH
+// 2PL and BAMBOO: resolve the index entries this many accesses ahead and
+// prefetch their rows, locks and data. 0 looks each row up when it is
+// accessed (runtime: -Gp)
+#define PREFETCH_DEPTH				0
 #define BTREE_ORDER 				16
 
 // [DL_DETECT]
@@ -68,6 +79,10 @@
 #define DL_LOOP_TRIAL				100	// 1 us
 #define NO_DL						KEY_ORDER
 #define TIMEOUT						1000000 // 1ms
+// detect from one dedicated thread every DL_LOOP_DETECT instead of from
+// every waiter, aborting a single victim per cycle
+#define DL_DETECT_THREAD			false
+#define DL_VICTIM_POLICY			DL_VICTIM_LOCKS
 // [TIMESTAMP]
 #define TS_TWR						false
 #define TS_ALLOC					TS_CAS
@@ -106,15 +121,62 @@
 #define BB_PRECOMMIT                false
 #define BB_AUTORETIRE               false
 #define BB_ALWAYS_RETIRE_READ       true
+// lock table of a row: BB_LT_LATCH, BB_LT_ATOMIC
+// BB_LT_ATOMIC lets readers join a read-only row with a single CAS on a
+// reader bitmap (threads < 62), and readers going to the retired tail
+// behind writers append with an atomic swap and hand the cohead on with a
+// CAS. Writers, waiters and removal from the lists still take the latch
+#define BB_LOCK_TABLE               BB_LT_LATCH
+// issue at most one atomic on a txn's commit_barriers per latched pass and
+// only CAS the barrier word at commit once it reads zero
+#define BB_BATCH_BARRIER            false
+// learn per row whether early retire pays off: writes to cold rows stay
+// private until commit and skip the rollback copy, hot rows retire early
+#define BB_ADAPTIVE_RETIRE          false
+// avg number of entries already queued on a row for it to count as hot
+#define BB_HOT_THRESHOLD            1
+// keep an undo image of only the columns a write changed (taken at retire)
+// instead of copying the whole tuple for rollback in get_row
+#define BB_UNDO_LOG                 false
+// keep waiters in a skip list on top of the ts-ordered waiter list, so that
+// inserting is O(log n) instead of a scan of the whole list
+#define BB_WAITER_SKIPLIST          false
+#define BB_WAITER_LEVELS            6
 // [WW]
-#define WW_STARV_FREE               false // set false if compared w/ bamboo
+// a retry keeps the ts of the txn's first attempt, so an aborted txn ages
+// until it wins its conflicts. Applies to WOUND_WAIT and BAMBOO, WAIT_DIE
+// always does it
+#define WW_STARV_FREE               false
 // [IC3]
 #define IC3_EAGER_EXEC              true
 #define IC3_RENDEZVOUS              true
 #define IC3_FIELD_LOCKING           false // should not be true
 #define IC3_MODIFIED_TPCC           false
+// [ORDERED_LOCK]
+// row lock: OL_PTHREAD (pthread_rwlock_t, 56 bytes), OL_RWSPIN (8-byte
+// reader/writer spinlock, waiting writers hold off new readers) or
+// OL_PFTICKET (16-byte phase-fair ticket lock, FIFO among writers)
+#define OL_LOCK                     OL_RWSPIN
 // [QCC]
 #define QCC_GENERAL                 false
+// scale the speculative runs a txn may do while waiting for its turn by how
+// often such a run ended up being used, per txn type
+#define QCC_SPEC_ADAPTIVE           true
+// with a budget of 0, still speculate once every QCC_SPEC_PROBE txns
+#define QCC_SPEC_PROBE              64
+// bytes of the per-txn redo log that holds the written columns until commit
+#define QCC_REDO_SIZE               16384
+// [BASIC_SCHED]
+// number of scheduler threads, each owns a range of the key hashes
+#define BASIC_SCHED_THREADS         1
+// empty doorbell polls before an idle scheduler sleeps, with WAIT_FUTEX
+#define BASIC_SCHED_IDLE_SPIN       1000
+// in ns, collect the requests of an epoch and admit them together, 0 admits
+// each request as it arrives (runtime: -Ge)
+#define BASIC_SCHED_EPOCH           0
+// also track the old key % size buckets and count the false conflicts
+// avoided by the exact-key table
+#define BASIC_SCHED_SHADOW          false
 
 /***********************************************/
 // Logging
@@ -154,6 +216,7 @@
 #define SYNTHETIC_YCSB              false
 #define POS_HS                      TOP
 #define SPECIFIED_RATIO             0
+// share of txns that swap the two hotspots, or with NUM_HS 1 access it as SECOND_HS
 #define FLIP_RATIO                  0
 #define NUM_HS                      1
 #define FIRST_HS                    WR
@@ -169,6 +232,12 @@
 #define TPCC_ACCESS_ALL 			false
 #define WH_UPDATE					true
 #define NUM_WH 						1
+// [TPCC_MGL] per-warehouse group lock over the stock rows for NO_WAIT,
+// WAIT_DIE, DL_DETECT and BAMBOO. new-order holds a cold group in X and skips
+// its stock row locks, see concurrency_control/mgl.h
+#define TPCC_MGL                    false
+#define TPCC_MGL_COLD               64
+#define TPCC_MGL_WAIT               100000 // 100 us
 //
 enum TPCCTxnType {
   TPCC_PAYMENT,
@@ -195,6 +264,8 @@ extern TPCCTxnType 					g_tpcc_txn_type;
 
 // Optimizations used in IC3
 #define COMMUTATIVE_OPS          false
+// merge ops a txn can queue on one access, applied at commit
+#define COM_OPS_PER_ACCESS       4
 
 /***********************************************/
 // TODO centralized CC management.
@@ -239,6 +310,11 @@ extern TestCases					g_test_case;
 #define PF_CS          					false // profiling inside critical path
 #define PF_ABORT_LENGTH          			false
 #define PF_MODEL          false
+// [BAMBOO] record wound/cascade edges in a per-thread ring buffer and print
+// a per-table cascade depth histogram and the hottest keys at exit
+#define PF_ABORT_GRAPH              false
+#define PF_ABORT_GRAPH_SIZE         (1UL << 16) // edges kept per thread
+#define PF_ABORT_GRAPH_TOPK         10
 
 /***********************************************/
 // Constant
@@ -254,6 +330,21 @@ extern TestCases					g_test_case;
 #define LH_SPINLOCK                   1
 #define LH_MUTEX                      2
 #define LH_MCSLOCK                    3
+// bamboo lock table options
+#define BB_LT_LATCH                   1
+#define BB_LT_ATOMIC                  2
+// wait strategy options
+#define WAIT_SPIN                     1
+#define WAIT_FUTEX                    2
+#define WAIT_BACKOFF                  3
+// ordered lock row locks
+#define OL_PTHREAD                    1
+#define OL_RWSPIN                     2
+#define OL_PFTICKET                   3
+// deadlock victim, the txn on the cycle with
+#define DL_VICTIM_LOCKS               1 // the fewest locks held
+#define DL_VICTIM_YOUNGEST            2 // the latest first start, restarts keep it
+#define DL_VICTIM_WORK                3 // the latest start of the current attempt
 // Concurrency Control Algorithm
 #define NO_WAIT						1
 #define WAIT_DIE					2
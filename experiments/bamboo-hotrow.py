@@ -0,0 +1,27 @@
+from exp import *
+
+# single hot row accessed by every txn (bamboo only): latched vs atomic lock table
+# ycsb 0 zipf 1 read 0 write 16pt, hotspot at the top of each txn, read by all
+# txns but a share (FLIP_RATIO) that write it
+
+hotrow = {
+    "SYNTHETIC_YCSB": "true",
+    "NUM_HS": "1",
+    "POS_HS": "TOP",
+    "FIRST_HS": "RD",
+    "SECOND_HS": "WR",
+}
+
+for wr in ["0", "0.1", "0.5"]:
+    for nr_threads in threadcnts:
+        mtxns = {}
+        for lt in ["BB_LT_LATCH", "BB_LT_ATOMIC"]:
+            extra = dict(hotrow)
+            extra["FLIP_RATIO"] = wr
+            extra["BB_LOCK_TABLE"] = lt
+            exp = ycsb(0, 1, 0, 16, nr_threads, "BAMBOO", extra)
+            mtxns[lt] = run_exp(exp, nr_threads)
+        if mtxns["BB_LT_LATCH"] and mtxns["BB_LT_ATOMIC"]:
+            print("speedup(atomic/latch) writers=%s threads=%s: %.3f" % (wr,
+                  nr_threads, mtxns["BB_LT_ATOMIC"] / mtxns["BB_LT_LATCH"]),
+                  flush=True)
@@ -0,0 +1,22 @@
+from exp import *
+
+# single hot row written by every txn (bamboo only): long waiter queues on it
+# ycsb 0 zipf 1 read 0 write 16pt, sorted list vs skip list waiters
+
+hotrow = {
+    "SYNTHETIC_YCSB": "true",
+    "NUM_HS": "1",
+    "POS_HS": "TOP",
+    "FIRST_HS": "WR",
+}
+
+for nr_threads in threadcnts + ["64"]:
+    mtxns = {}
+    for skiplist in ["false", "true"]:
+        extra = dict(hotrow)
+        extra["BB_WAITER_SKIPLIST"] = skiplist
+        exp = ycsb(0, 1, 0, 16, nr_threads, "BAMBOO", extra)
+        mtxns[skiplist] = run_exp(exp, nr_threads)
+    if mtxns["false"] and mtxns["true"]:
+        print("speedup(skiplist/list) threads=%s: %.3f" % (nr_threads,
+              mtxns["true"] / mtxns["false"]), flush=True)
@@ -0,0 +1,17 @@
+from exp import *
+
+# ycsb 0.9 zipf 0.5 read 0.5 write 16pt with DL_DETECT up to 128 threads:
+# cost of a cycle detection (detect_per_call_us) as the waits-for graph grows
+
+for nr_threads in ["8", "16", "32", "64", "96", "128"]:
+    exp = ycsb(0.9, 0.5, 0.5, 16, nr_threads, "DL_DETECT")
+    run_exp(exp, nr_threads)
+
+# the same with a dedicated detector thread and each victim policy:
+# deadlocks resolved and duplicate detections avoided (dup_avoided)
+
+for policy in ["DL_VICTIM_LOCKS", "DL_VICTIM_YOUNGEST", "DL_VICTIM_WORK"]:
+    for nr_threads in ["8", "32", "128"]:
+        exp = ycsb(0.9, 0.5, 0.5, 16, nr_threads, "DL_DETECT",
+                   {"DL_DETECT_THREAD": "true", "DL_VICTIM_POLICY": policy})
+        run_exp(exp, nr_threads)
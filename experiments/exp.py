@@ -7,10 +7,12 @@ supported_ccalgs = [
     "ORDERED_LOCK",
     "BASIC_SCHED",
     "BAMBOO",
+    "WOUND_WAIT",
     "SILO",
     "TICTOC",
     "WAIT_DIE",
     "NO_WAIT",
+    "DL_DETECT",
 ]
 
 threadcnts = ["1", "2", "4", "8", "16", "24", "32"]
@@ -37,7 +39,14 @@ def config(params):
             fout.write(" ".join(tokens) + '\n')
 
 
-def ycsb(theta=0.99, read=0.5, write=0.5, nr_reqs=16, nr_threads=1, alg="QCC"):
+# extra: additional config-std.h macros, appended to the experiment name
+def exp_suffix(extra):
+    if not extra:
+        return ""
+    return "".join("-%s" % v for (_, v) in sorted(extra.items()))
+
+
+def ycsb(theta=0.99, read=0.5, write=0.5, nr_reqs=16, nr_threads=1, alg="QCC", extra=None):
     theta = str(theta)
     read = str(read)
     write = str(write)
@@ -53,13 +62,15 @@ def ycsb(theta=0.99, read=0.5, write=0.5, nr_reqs=16, nr_threads=1, alg="QCC"):
         "THREAD_CNT": nr_threads,
         "CC_ALG": alg,
     }
+    if extra:
+        params.update(extra)
 
     config(params)
     exp = "ycsb-%s-%s-%s-%s-%s-%s" % (theta, read, write, nr_reqs, nr_threads, alg)
-    return exp
+    return exp + exp_suffix(extra)
 
 
-def tpcc(nr_wh=1, perc_payment=0.5, nr_threads=1, alg="QCC"):
+def tpcc(nr_wh=1, perc_payment=0.5, nr_threads=1, alg="QCC", extra=None):
     nr_wh = str(nr_wh)
     perc_payment = str(perc_payment)
     nr_threads = str(nr_threads)
@@ -70,19 +81,26 @@ def tpcc(nr_wh=1, perc_payment=0.5, nr_threads=1, alg="QCC"):
         "THREAD_CNT": nr_threads,
         "CC_ALG": alg,
     }
+    if extra:
+        params.update(extra)
     config(params)
     exp = "tpcc-%s-%s-%s-%s" % (nr_wh, perc_payment, nr_threads, alg)
-    return exp
+    return exp + exp_suffix(extra)
 
 
-def run_exp(exp, nr_threads):
+# returns the throughput (mtxns) of the run, or None if it failed
+# args: extra rundb command line flags, appended to the experiment name
+def run_exp(exp, nr_threads, args=None):
     nr_threads = str(nr_threads)
+    mtxns = None
     # max 64 accesses according to config-std.h
     ret = os.system("make --no-print-directory -C .. QCC_WORKERS=%s QCC_MAX_ACCESSES=64 -B -j16 > /dev/null 2>&1" % (nr_threads))
     if (ret != 0):
         print("%s compile fails returns %s" % {exp, str(ret)}, flush=True)
     else:
-        result = subprocess.check_output(["../rundb"], stderr=subprocess.STDOUT).decode("utf-8")
+        args = args or []
+        exp = " ".join([exp] + args)
+        result = subprocess.check_output(["../rundb"] + args, stderr=subprocess.STDOUT).decode("utf-8")
         if "PASS" in result:
             result = result.split("\n")
             result = [r.strip() for r in result]
@@ -91,6 +109,9 @@ def run_exp(exp, nr_threads):
                 if "summary!" in l:
                     ll = l.strip().split(" ", 1)
                     print(ll[1], flush=True)
+                    if ll[1].startswith("mtxns="):
+                        mtxns = float(ll[1].split(",")[0].split("=")[1])
         else:
             print("%s fails" % (exp), flush=True)
     os.system("make --no-print-directory -C .. -j16 clean &> /dev/null")
+    return mtxns
@@ -0,0 +1,22 @@
+from exp import *
+
+# ycsb 0.6 zipf 0.5 read 0.5 write 16pt, tables from LLC-sized to far beyond
+# it (rows are 100B), and tpcc 16wh new-order only: the index entries
+# resolved PREFETCH_DEPTH accesses ahead (-Gp) vs looked up one at a time
+
+depths = ["0", "2", "4", "8"]
+
+for alg in get_algs() or ["NO_WAIT", "WAIT_DIE", "BAMBOO"]:
+    for size in ["(1024 * 1024)", "(16 * 1024 * 1024)", "(100 * 1024 * 1024)"]:
+        exp = ycsb(0.6, 0.5, 0.5, 16, 16, alg, {"SYNTH_TABLE_SIZE": size})
+        mtxns = {}
+        for depth in depths:
+            mtxns[depth] = run_exp(exp, 16, ["-Gp" + depth])
+        for depth in depths[1:]:
+            if mtxns[depth] and mtxns["0"]:
+                print("speedup(depth %s) %s size=%s: %.3f" % (depth, alg, size,
+                      mtxns[depth] / mtxns["0"]), flush=True)
+
+    exp = tpcc(16, 0, 16, alg)
+    for depth in depths:
+        run_exp(exp, 16, ["-Gp" + depth])
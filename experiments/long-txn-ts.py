@@ -0,0 +1,19 @@
+from exp import *
+
+# ycsb 0.9 zipf 0.5 read 0.5 write 16pt with 1% long txns (MAX_ROW_PER_TXN
+# rows, half read): retries that keep the ts of their first attempt
+# (WW_STARV_FREE) vs a fresh ts per attempt. The long txns' own latency
+# percentiles are reported separately ("long txn commit latency").
+
+for alg in get_algs() or ["WOUND_WAIT", "BAMBOO", "WAIT_DIE"]:
+    for retain in ["false", "true"]:
+        # WAIT_DIE always retains
+        if alg == "WAIT_DIE" and retain == "false":
+            continue
+        for nr_threads in threadcnts:
+            exp = ycsb(0.9, 0.5, 0.5, 16, nr_threads, alg, {
+                "LONG_TXN_RATIO": "0.01",
+                "LONG_TXN_READ_RATIO": "0.5",
+                "WW_STARV_FREE": retain,
+            })
+            run_exp(exp, nr_threads)
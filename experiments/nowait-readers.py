@@ -0,0 +1,16 @@
+from exp import *
+
+# single hot row read by every txn, the rest of the txn is uniform:
+# NO_WAIT takes and drops the shared lock with one CAS on the lock word,
+# WAIT_DIE and DL_DETECT still latch the row but unlink the owner in O(1)
+
+hotrow = {
+    "SYNTHETIC_YCSB": "true",
+    "NUM_HS": "1",
+    "POS_HS": "TOP",
+    "FIRST_HS": "RD",
+}
+for alg in ["NO_WAIT", "WAIT_DIE", "DL_DETECT"]:
+    for nr_threads in threadcnts:
+        exp = ycsb(0, 0.9, 0.1, 16, nr_threads, alg, hotrow)
+        run_exp(exp, nr_threads)
@@ -0,0 +1,25 @@
+from exp import *
+
+# single hot row read or written by every txn (ordered lock only):
+# pthread_rwlock_t vs the 8-byte spinlock vs the phase-fair ticket lock.
+# ycsb 0 zipf 16 req, hotspot at the top of each txn. ol_lock_mb reports the
+# lock state of the table.
+
+for first in ["RD", "WR"]:
+    hotrow = {
+        "SYNTHETIC_YCSB": "true",
+        "NUM_HS": "1",
+        "POS_HS": "TOP",
+        "FIRST_HS": first,
+    }
+    for nr_threads in threadcnts:
+        mtxns = {}
+        for lock in ["OL_PTHREAD", "OL_RWSPIN", "OL_PFTICKET"]:
+            extra = dict(hotrow)
+            extra["OL_LOCK"] = lock
+            exp = ycsb(0, 0.5, 0.5, 16, nr_threads, "ORDERED_LOCK", extra)
+            mtxns[lock] = run_exp(exp, nr_threads)
+        for lock in ["OL_RWSPIN", "OL_PFTICKET"]:
+            if mtxns[lock] and mtxns["OL_PTHREAD"]:
+                print("speedup(%s/pthread) %s threads=%s: %.3f" % (lock, first,
+                      nr_threads, mtxns[lock] / mtxns["OL_PTHREAD"]), flush=True)
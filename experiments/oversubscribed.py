@@ -0,0 +1,21 @@
+from exp import *
+
+# more worker threads than cores: spinning waiters steal the cpu from the
+# lock holders they wait for. ycsb 0.9 zipf 0.5 read 0.5 write 16pt
+
+strategies = ["WAIT_SPIN", "WAIT_FUTEX", "WAIT_BACKOFF"]
+nr_cores = os.cpu_count()
+
+ccalgs = get_algs() or ["BAMBOO", "WOUND_WAIT", "WAIT_DIE"]
+for alg in ccalgs:
+    for factor in [1, 2, 4]:
+        nr_threads = nr_cores * factor
+        mtxns = {}
+        for ws in strategies:
+            exp = ycsb(0.9, 0.5, 0.5, 16, nr_threads, alg, {"WAIT_STRATEGY": ws})
+            mtxns[ws] = run_exp(exp, nr_threads)
+        if mtxns["WAIT_SPIN"]:
+            for ws in strategies[1:]:
+                if mtxns[ws]:
+                    print("speedup(%s/spin) %s threads=%d (x%d): %.3f" % (ws, alg,
+                          nr_threads, factor, mtxns[ws] / mtxns["WAIT_SPIN"]), flush=True)
@@ -0,0 +1,10 @@
+from exp import *
+
+# BASIC_SCHED with the exact-key conflict table: how many grants the old
+# key % BASIC_SCHED_SIZE buckets would have refused (false_conflicts_avoided)
+
+shadow = {"BASIC_SCHED_SHADOW": "true"}
+for nr_threads in threadcnts:
+    run_exp(ycsb(0.99, 0.5, 0.5, 16, nr_threads, "BASIC_SCHED", shadow), nr_threads)
+    run_exp(ycsb(0.5, 0.5, 0.5, 16, nr_threads, "BASIC_SCHED", shadow), nr_threads)
+    run_exp(tpcc(1, 0.5, nr_threads, "BASIC_SCHED", shadow), nr_threads)
@@ -0,0 +1,16 @@
+from exp import *
+
+# tpcc 50% payment, one warehouse per 4 threads and one per thread:
+# stock row locks vs the per-warehouse stock group lock (TPCC_MGL)
+
+ccalgs = get_algs() or ["NO_WAIT", "WAIT_DIE", "BAMBOO"]
+for alg in ccalgs:
+    for nr_threads in threadcnts:
+        for nr_wh in sorted(set([max(1, int(nr_threads) // 4), int(nr_threads)])):
+            mtxns = {}
+            for mgl in ["false", "true"]:
+                exp = tpcc(nr_wh, 0.5, nr_threads, alg, {"TPCC_MGL": mgl})
+                mtxns[mgl] = run_exp(exp, nr_threads)
+            if mtxns["false"] and mtxns["true"]:
+                print("speedup(mgl) %s threads=%s wh=%d: %.3f" % (alg, nr_threads,
+                      nr_wh, mtxns["true"] / mtxns["false"]), flush=True)
@@ -0,0 +1,10 @@
+from exp import *
+
+# tpcc 50% payment with one warehouse per thread: QCC with a single queue set
+# vs one per warehouse (PART_CNT = NUM_WH). Remote payments and new_orders
+# make some txns multi-partition (see mp_rate).
+
+for nr_threads in threadcnts:
+    for nr_parts in sorted(set(["1", nr_threads]), key=int):
+        exp = tpcc(nr_threads, 0.5, nr_threads, "QCC", {"PART_CNT": nr_parts})
+        run_exp(exp, nr_threads)
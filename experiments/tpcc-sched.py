@@ -0,0 +1,9 @@
+from exp import *
+
+# tpcc 50% payment on one warehouse: BASIC_SCHED with 1, 2, 4 and 8
+# scheduler threads (shards). Workers are pinned after the schedulers.
+
+for nr_threads in threadcnts:
+    for nr_shards in ["1", "2", "4", "8"]:
+        exp = tpcc(1, 0.5, nr_threads, "BASIC_SCHED", {"BASIC_SCHED_THREADS": nr_shards})
+        run_exp(exp, nr_threads)
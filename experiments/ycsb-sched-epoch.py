@@ -0,0 +1,11 @@
+from exp import *
+
+# ycsb 50% write, 16 requests per txn: BASIC_SCHED admitting requests as
+# they arrive (epoch 0) vs batch admission with epochs of 1, 5 and 20us
+
+epochs = ["0", "1000", "5000", "20000"]
+for theta in [0.6, 0.8, 0.9, 0.99]:
+    for nr_threads in threadcnts:
+        for epoch in epochs:
+            exp = ycsb(theta, 0.5, 0.5, 16, nr_threads, "BASIC_SCHED")
+            run_exp(exp, nr_threads, ["-Ge%s" % epoch])
@@ -4,15 +4,29 @@
 
 void
 Catalog::init(const char * table_name, int field_cnt) {
-	this->table_name = table_name;
+	// the caller passes a temporary (the schema parser's std::string)
+	this->table_name = strdup(table_name);
 	this->field_cnt = 0;
 	this->_columns = new Column [field_cnt];
 	this->tuple_size = 0;
 }
 
+static data_t parse_dtype(const char * type, uint64_t size) {
+	if (size != sizeof(uint64_t))
+		return DT_OTHER;
+	if (strcmp(type, "double") == 0)
+		return DT_DOUBLE;
+	if (strcmp(type, "int64_t") == 0)
+		return DT_INT64;
+	if (strcmp(type, "uint64_t") == 0)
+		return DT_UINT64;
+	return DT_OTHER;
+}
+
 void Catalog::add_col(char * col_name, uint64_t size, char * type) {
 	_columns[field_cnt].size = size;
 	strcpy(_columns[field_cnt].type, type);
+	_columns[field_cnt].dtype = parse_dtype(type, size);
 	strcpy(_columns[field_cnt].name, col_name);
 	_columns[field_cnt].id = field_cnt;
 	_columns[field_cnt].index = tuple_size;
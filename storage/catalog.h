@@ -28,7 +28,8 @@ public:
 	UInt32 index;
 	char * type;
 	char * name;
-	char pad[CL_SIZE - sizeof(uint64_t)*3 - sizeof(char *)*2];
+	data_t dtype;
+	char pad[CL_SIZE - sizeof(uint64_t)*3 - sizeof(char *)*2 - sizeof(data_t)];
 };
 
 class Catalog {
@@ -47,6 +48,7 @@ public:
 	uint64_t 		get_field_size(int id) { return _columns[id].size; };
 	uint64_t 		get_field_index(int id) { return _columns[id].index; };
 	char * 			get_field_type(uint64_t id);
+	data_t 			get_field_dtype(uint64_t id) { return _columns[id].dtype; };
 	char * 			get_field_name(uint64_t id);
 	uint64_t 		get_field_id(const char * name);
 	char * 			get_field_type(char * name);
@@ -33,6 +33,9 @@ row_t::init(table_t * host_table, uint64_t part_id, uint64_t row_id) {
 #if CC_ALG == IC3
   txn_access = NULL;
   orig = NULL;
+#elif CC_ALG == QCC
+  orig = NULL;
+  redo_txn = NULL;
 #endif
   return RCOK;
 }
@@ -49,6 +52,10 @@ void
 row_t::init(int size)
 {
   data = (char *) _mm_malloc(size, 64);
+#if CC_ALG == QCC
+  orig = NULL;
+  redo_txn = NULL;
+#endif
 }
 
 RC
@@ -114,14 +121,46 @@ uint64_t row_t::get_field_cnt() {
   return get_schema()->field_cnt;
 }
 
-void row_t::inc_value(int id, uint64_t val) {
-  int pos = get_schema()->get_field_index(id);
-  ATOM_ADD(data[pos], val);
+static uint64_t merge_bits(data_t type, com_t op, uint64_t cur, uint64_t val) {
+  if (type == DT_DOUBLE) {
+    double c, v;
+    memcpy(&c, &cur, sizeof(double));
+    memcpy(&v, &val, sizeof(double));
+    if (op == COM_ADD)
+      c += v;
+    else if (op == COM_MAX)
+      c = max(c, v);
+    else
+      c = min(c, v);
+    memcpy(&cur, &c, sizeof(double));
+    return cur;
+  } else if (type == DT_INT64) {
+    int64_t c = (int64_t) cur, v = (int64_t) val;
+    return (uint64_t) ((op == COM_MAX)? max(c, v) : min(c, v));
+  } else {
+    return (op == COM_MAX)? max(cur, val) : min(cur, val);
+  }
 }
 
-void row_t::dec_value(int id, uint64_t val) {
-  int pos = get_schema()->get_field_index(id);
-  ATOM_SUB(data[pos], val);
+// [COMMUTATIVE OPERATIONS] apply a merge op to an 8-byte numeric column
+// without holding the row's lock. val already has the column's type (see
+// txn_man::merge_value).
+void row_t::merge_value(int id, com_t op, uint64_t val) {
+  Catalog * schema = get_schema();
+  data_t type = schema->get_field_dtype(id);
+  assert(type != DT_OTHER);
+  uint64_t * slot = (uint64_t *) &data[schema->get_field_index(id)];
+  if (op == COM_CNT || (op == COM_ADD && type != DT_DOUBLE)) {
+    ATOM_ADD(*slot, val);
+    return;
+  }
+  uint64_t cur, next;
+  do {
+    cur = *(volatile uint64_t *) slot;
+    next = merge_bits(type, op, cur, val);
+    if (next == cur)
+      return;
+  } while (!ATOM_CAS(*slot, cur, next));
 }
 
 void row_t::set_value(int id, void * ptr) {
@@ -131,6 +170,15 @@ void row_t::set_value(int id, void * ptr) {
   // assume no blind writes.
   if (txn_access)
     txn_access->wr_accesses = (txn_access->wr_accesses | (1UL << id));
+#endif
+#if ROW_TRACK_WR_COLS
+  mark_written(id);
+#endif
+#if CC_ALG == QCC
+  if (redo_txn) {
+    memcpy(redo_txn->qcc_redo_col(this, id), ptr, datasize);
+    return;
+  }
 #endif
   memcpy( &data[pos], ptr, datasize);
   //debugging
@@ -144,6 +192,16 @@ void row_t::set_value(int id, void * ptr, int size) {
   // assume no blind writes.
   if (txn_access)
     txn_access->wr_accesses = (txn_access->wr_accesses | (1UL << id));
+#endif
+#if ROW_TRACK_WR_COLS
+  mark_written(id);
+#endif
+#if CC_ALG == QCC
+  if (redo_txn) {
+    // the rest of the column keeps its committed value
+    memcpy(redo_txn->qcc_redo_col(this, id), ptr, size);
+    return;
+  }
 #endif
   memcpy( &data[pos], ptr, size);
   //debugging
@@ -187,6 +245,13 @@ char * row_t::get_value(int idx) {
 
 char * row_t::get_value_plain(uint64_t id) {
   int pos = get_schema()->get_field_index(id);
+#if CC_ALG == QCC
+  if (redo_txn) {
+    char * redo = redo_txn->qcc_redo_find(orig, pos);
+    if (redo)
+      return redo;
+  }
+#endif
   return &data[pos];
 }
 
@@ -198,6 +263,10 @@ char * row_t::get_value(char * col_name) {
     txn_access->rd_accesses = (txn_access->rd_accesses | (1UL << id));
     // copy data from orig row
   }
+#endif
+#if CC_ALG == QCC
+  if (redo_txn)
+    return get_value_plain(get_schema()->get_field_id(col_name));
 #endif
   uint64_t pos = get_schema()->get_field_index(col_name);
   return &data[pos];
@@ -224,6 +293,17 @@ void row_t::set_value_plain(int idx, void * ptr) {
   assert(ptr);
 }
 
+void row_t::copy_cols(row_t * src, uint64_t cols) {
+  if (cols == ~0UL) {
+    copy(src);
+    return;
+  }
+  while (cols) {
+    copy(src, __builtin_ctzl(cols));
+    cols &= cols - 1;
+  }
+}
+
 void row_t::copy(row_t * src, int idx) {
   char * ptr = src->get_value_plain(idx);
   set_value_plain(idx, ptr);
@@ -253,7 +333,7 @@ RC row_t::get_row(access_t type, txn_man * txn, row_t *& row, Access * access) {
   #if CC_ALG == DL_DETECT
   uint64_t * txnids;
   int txncnt;
-  rc = this->manager->lock_get(lt, txn, txnids, txncnt);
+  rc = this->manager->lock_get(lt, txn, txnids, txncnt, access);
   #elif CC_ALG == BAMBOO || CC_ALG == WOUND_WAIT
   if (txn->lock_abort) {
     row = NULL;
@@ -273,6 +353,8 @@ RC row_t::get_row(access_t type, txn_man * txn, row_t *& row, Access * access) {
     uint64_t starttime = get_server_clock();
     #if CC_ALG == DL_DETECT
     bool dep_added = false;
+    uint64_t last_detect = starttime;
+    uint64_t last_try = starttime;
     #endif
     uint64_t endtime;
     #if (CC_ALG != WOUND_WAIT) && (CC_ALG != BAMBOO)
@@ -282,10 +364,8 @@ RC row_t::get_row(access_t type, txn_man * txn, row_t *& row, Access * access) {
     while (!txn->lock_ready && !txn->lock_abort)
     {
     #if CC_ALG == WAIT_DIE || (CC_ALG == WOUND_WAIT) || (CC_ALG == BAMBOO)
-      continue;
+      txn->wait_lock();
     #elif CC_ALG == DL_DETECT
-      uint64_t last_detect = starttime;
-      uint64_t last_try = starttime;
       uint64_t now = get_server_clock();
       if (now - starttime > g_timeout ) {
 				txn->lock_abort = true;
@@ -298,13 +378,14 @@ RC row_t::get_row(access_t type, txn_man * txn, row_t *& row, Access * access) {
       int ok = 0;
       if ((now - last_detect > g_dl_loop_detect) && (now - last_try > DL_LOOP_TRIAL)) {
         if (!dep_added) {
-          ok = dl_detector.add_dep(txn->get_txn_id(), txnids, txncnt, txn->row_cnt);
+          ok = dl_detector.add_dep(txn, txnids, txncnt);
 	  if (ok == 0)
             dep_added = true;
           else if (ok == 16)
 	  last_try = now;
         }
-	if (dep_added) {
+	// the detector thread finds the loop and signals the victim
+	if (dep_added && !DL_DETECT_THREAD) {
 	  ok = dl_detector.detect_cycle(txn->get_txn_id());
 	  if (ok == 16)  // failed to lock the deadlock detector
 	    last_try = now;
@@ -318,6 +399,12 @@ RC row_t::get_row(access_t type, txn_man * txn, row_t *& row, Access * access) {
         PAUSE
     #endif
     }
+    #if CC_ALG == DL_DETECT
+    mem_allocator.free(txnids, sizeof(uint64_t) * txncnt);
+    // no longer waiting, so no longer on any loop
+    if (dep_added)
+      dl_detector.clear_dep(txn->get_txn_id());
+    #endif
     if (txn->lock_ready) {
       rc = RCOK;
     } else if (txn->lock_abort) {
@@ -326,6 +413,10 @@ RC row_t::get_row(access_t type, txn_man * txn, row_t *& row, Access * access) {
       // try to release lock
 #if (CC_ALG == WOUND_WAIT) || (CC_ALG == BAMBOO)
       return_row(access->lock_entry, Abort);
+#elif CC_ALG == DL_DETECT
+      // not in the txn's accesses yet, leave the waiters (or the owners,
+      // if granted meanwhile) here
+      this->manager->lock_release(access->lock_entry);
 #endif
       return Abort;
     }
@@ -389,10 +480,13 @@ RC row_t::get_row(access_t type, txn_man * txn, row_t *& row, Access * access) {
 #elif CC_ALG == QCC
     assert(rc == RCOK);
     if (type == WR) {
-        // for write, point the data ptr to buf
-        row = access->buf; // data = buf
+        // for write, hand out a header over this row's data, set_value goes
+        // to the txn's redo log and get_value sees the txn's own writes
+        row = access->buf;
         row->table = get_table();
-        row->copy(this); // copy to buf..
+        row->data = data;
+        row->orig = this;
+        row->redo_txn = txn;
     } else {
         // otherwise, just refer the original row in data
         row = this;
@@ -18,6 +18,9 @@
           value = *(type *)get_value(col_id); \
         }
 
+// local copies remember which columns the txn wrote
+#define ROW_TRACK_WR_COLS (CC_ALG == BAMBOO && BB_UNDO_LOG)
+
 //		int pos = get_schema()->get_field_index(col_id);
 //		value = *(type *)&data[pos];
 //	}
@@ -66,6 +69,8 @@ class row_t
 
     void copy(row_t * src);
     void copy(row_t * src, int idx);
+    // copy the columns set in cols, all of them if cols is ~0
+    void copy_cols(row_t * src, uint64_t cols);
 
     void 		set_primary_key(uint64_t key) { _primary_key = key; };
     uint64_t 	get_primary_key() {return _primary_key; };
@@ -78,8 +83,7 @@ class row_t
     char * get_value(int id);
     char * get_value_plain(uint64_t id);
     char * get_value(char * col_name);
-    void inc_value(int id, uint64_t val);
-    void dec_value(int id, uint64_t val);
+    void merge_value(int id, com_t op, uint64_t val);
 
     DECL_SET_VALUE(uint64_t);
     DECL_SET_VALUE(int64_t);
@@ -106,6 +110,16 @@ class row_t
     row_t * orig;
     void init_accesses(Access * access);
     Access * txn_access; // only used when row is a local copy
+#elif CC_ALG == QCC
+    // only used when row is a local copy: data is orig's, and the written
+    // columns stay in redo_txn's redo log until commit
+    row_t * orig;
+    txn_man * redo_txn;
+#endif
+#if ROW_TRACK_WR_COLS
+    // only used when row is a local copy, columns >= 64 mark everything
+    uint64_t wr_cols;
+    void mark_written(int id) { wr_cols |= (id < 64)? (1UL << id) : ~0UL; };
 #endif
     RC get_row(access_t type, txn_man * txn, row_t *& row, Access *access=NULL);
 #if CC_ALG == BAMBOO
@@ -36,6 +36,8 @@ ts_t g_timeout = TIMEOUT;
 ts_t g_dl_loop_detect = DL_LOOP_DETECT;
 bool g_ts_batch_alloc = TS_BATCH_ALLOC;
 UInt32 g_ts_batch_num = TS_BATCH_NUM;
+ts_t g_bs_epoch = BASIC_SCHED_EPOCH;
+UInt32 g_prefetch_depth = PREFETCH_DEPTH;
 
 bool g_part_alloc = PART_ALLOC;
 bool g_mem_pad = MEM_PAD;
@@ -92,6 +92,8 @@ extern ts_t g_timeout;
 extern ts_t g_dl_loop_detect;
 extern bool g_ts_batch_alloc;
 extern UInt32 g_ts_batch_num;
+extern ts_t g_bs_epoch;
+extern UInt32 g_prefetch_depth;
 
 extern map<string, string> g_params;
 
@@ -159,7 +161,11 @@ enum TsType {R_REQ, W_REQ, P_REQ, XP_REQ};
 enum status_t: unsigned int {RUNNING, ABORTED, COMMITED, HOLDING};
 
 /* COMMUTATIVE OPERATIONS */
-enum com_t {COM_INC, COM_DEC, COM_NONE};
+// merge operators, see row_t::merge_value. COM_CNT is an unsigned counter
+// that only grows (e.g. number of appended entries)
+enum com_t {COM_ADD, COM_MAX, COM_MIN, COM_CNT, COM_NONE};
+/* column types the merge operators understand */
+enum data_t {DT_INT64, DT_UINT64, DT_DOUBLE, DT_OTHER};
 
 
 #define MSG(str, args...) { \
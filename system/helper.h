@@ -3,6 +3,9 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdint.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include "global.h"
 #include "qcc.h"
 
@@ -30,6 +33,17 @@
 #define PAUSE { __asm__ ( "pause;" ); }
 //#define PAUSE usleep(1);
 
+// sleep while *addr == val, at most timeout_ns
+inline void futex_wait(volatile uint32_t * addr, uint32_t val, uint64_t timeout_ns) {
+	struct timespec ts;
+	ts.tv_sec = timeout_ns / 1000000000UL;
+	ts.tv_nsec = timeout_ns % 1000000000UL;
+	syscall(SYS_futex, (uint32_t *) addr, FUTEX_WAIT_PRIVATE, val, &ts, NULL, 0);
+}
+inline void futex_wake(volatile uint32_t * addr) {
+	syscall(SYS_futex, (uint32_t *) addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
 /************************************************/
 // ASSERT Helper
 /************************************************/
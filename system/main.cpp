@@ -10,6 +10,8 @@
 #include "occ.h"
 #include "vll.h"
 #include "basic_sched.h"
+#include "table.h"
+#include "row_ol.h"
 
 void * f(void *);
 
@@ -48,11 +50,6 @@ int main(int argc, char* argv[])
 	printf("BASIC_SCHED\n");
 #elif CC_ALG == QCC
 	printf("QCC\n");
-    if (g_part_cnt != 1) {
-        printf("qcc does not support multiple partitions\n");
-        fflush(stdout);
-        exit(1);
-    }
 #endif
 
 	workload * m_wl;
@@ -77,6 +74,7 @@ int main(int argc, char* argv[])
     for (uint32_t i = 0; i < thd_cnt; i++) {
 		m_thds[i] = (thread_t *) _mm_malloc(sizeof(thread_t), 64);
         m_thds[i]->txn_commit_latency.reset();
+        m_thds[i]->txn_commit_latency_long.reset();
     }
 	// query_queue should be the last one to be initialized!!!
 	// because it collects txn latency
@@ -100,22 +98,34 @@ int main(int argc, char* argv[])
 #if CC_ALG == QCC
     u64 nr_workers = g_thread_cnt;
 #if WORKLOAD == YCSB || WORKLOAD == TPCC
-    struct qcc *const q = qcc_create(nr_workers);
-    m_wl->q = q;
-    printf("qcc init (m_wl->q = %p) nr_workers %lu\n", q, nr_workers);
+    // a queue set per partition, every worker may enqueue in any of them
+    m_wl->q = (struct qcc **) _mm_malloc(sizeof(struct qcc *) * g_part_cnt, 64);
+    for (UInt32 p = 0; p < g_part_cnt; p++)
+        m_wl->q[p] = qcc_create(nr_workers);
+    printf("qcc init (m_wl->q = %p) nr_workers %lu nr_parts %u\n", m_wl->q, nr_workers, g_part_cnt);
 #else
     assert(false);
 #endif
 #endif
 
+#if CC_ALG == ORDERED_LOCK
+    // lock state kept for the loaded rows
+    uint64_t nr_rows = 0;
+    for (auto it = m_wl->tables.begin(); it != m_wl->tables.end(); it++)
+        nr_rows += it->second->get_table_size();
+    printf("[summary!] ol_lock_bytes=%lu, ol_rows=%lu, ol_lock_mb=%.1f\n",
+           sizeof(Row_ol), nr_rows, sizeof(Row_ol) * nr_rows / 1048576.0);
+#endif
+
 #if CC_ALG == BASIC_SCHED
     u64 nr_workers = g_thread_cnt;
 #if WORKLOAD == YCSB || WORKLOAD == TPCC
-    pthread_t sched_thd;
+    pthread_t sched_thds[BASIC_SCHED_THREADS];
     struct basic_sched *const s = basic_sched_create();
     m_wl->s = s;
-    pthread_create(&sched_thd, NULL, basic_sched_run, (void *)s);
-    printf("basic_sched init (m_wl->s = %p)\n", s);
+    for (u64 k = 0; k < BASIC_SCHED_THREADS; k++)
+        pthread_create(&sched_thds[k], NULL, basic_sched_run, (void *)&s->shard[k]);
+    printf("basic_sched init (m_wl->s = %p) nr_shards %d\n", s, BASIC_SCHED_THREADS);
 #else
     assert(false);
 #endif
@@ -140,6 +150,12 @@ int main(int argc, char* argv[])
 	// pthread_barrier_init( &warmup_bar, NULL, g_thread_cnt );
 
 
+#if CC_ALG == DL_DETECT && DL_DETECT_THREAD
+	pthread_t dl_thd;
+	if (!g_no_dl)
+		pthread_create(&dl_thd, NULL, DL_detect::run, (void *)&dl_detector);
+#endif
+
 	// spawn and run txns again.
 	for (uint32_t i = 0; i < thd_cnt; i++) {
 		uint64_t vid = i;
@@ -152,9 +168,29 @@ int main(int argc, char* argv[])
 		pthread_join(p_thds[i], NULL);
     }
 
+#if CC_ALG == DL_DETECT && DL_DETECT_THREAD
+	if (!g_no_dl) {
+		dl_detector.stop();
+		pthread_join(dl_thd, NULL);
+		printf("[summary!] dl_detector passes=%lu, deadlocks=%lu, dup_avoided=%lu, detect_time=%.4f\n",
+			dl_detector.nr_passes, dl_detector.nr_deadlocks, dl_detector.nr_dups,
+			dl_detector.time_detect / 1e9);
+	}
+#endif
+
 #if CC_ALG == BASIC_SCHED
     s->valid = 0;
-    pthread_join(sched_thd, NULL);
+    for (u64 k = 0; k < BASIC_SCHED_THREADS; k++) {
+        pthread_join(sched_thds[k], NULL);
+#if BASIC_SCHED_SHADOW
+        printf("[summary!] basic_sched shard=%lu, scheduled=%lu, retries=%lu, epochs=%lu, false_conflicts_avoided=%lu\n",
+               k, s->shard[k].nr_scheduled, s->shard[k].nr_retries, s->shard[k].nr_epochs,
+               s->shard[k].nr_false_conflicts);
+#else
+        printf("[summary!] basic_sched shard=%lu, scheduled=%lu, retries=%lu, epochs=%lu\n",
+               k, s->shard[k].nr_scheduled, s->shard[k].nr_retries, s->shard[k].nr_epochs);
+#endif
+    }
 #endif
 	uint64_t endtime = get_server_clock();
 
@@ -177,9 +213,22 @@ int main(int argc, char* argv[])
          txn_commit_latency.avg(), txn_commit_latency.perc(0.50),
          txn_commit_latency.perc(0.95), txn_commit_latency.perc(0.99),
          txn_commit_latency.perc(0.999));
+#if WORKLOAD == YCSB
+	if (g_long_txn_ratio > 0) {
+		Stat_latency txn_commit_latency_long;
+		for (uint32_t i = 0; i < thd_cnt; i++)
+			txn_commit_latency_long += m_thds[i]->txn_commit_latency_long;
+		printf("[summary!] long txn commit latency (us): min=%lu, max=%lu, avg=%lu; 50-th=%lu, 95-th=%lu, 99-th=%lu, 99.9-th=%lu\n",
+			txn_commit_latency_long.min(), txn_commit_latency_long.max(),
+			txn_commit_latency_long.avg(), txn_commit_latency_long.perc(0.50),
+			txn_commit_latency_long.perc(0.95), txn_commit_latency_long.perc(0.99),
+			txn_commit_latency_long.perc(0.999));
+	}
+#endif
 
 #if CC_ALG == QCC
-    qcc_destroy(q);
+    for (UInt32 p = 0; p < g_part_cnt; p++)
+        qcc_destroy(m_wl->q[p]);
 #endif
 
 	return 0;
@@ -20,6 +20,8 @@ void print_usage() {
 
 	printf("\t-GbINT      ; TS_BATCH_ALLOC\n");
 	printf("\t-GuINT      ; TS_BATCH_NUM\n");
+	printf("\t-GeINT      ; BASIC_SCHED_EPOCH (in ns)\n");
+	printf("\t-GpINT      ; PREFETCH_DEPTH\n");
 
 	printf("\t-o STRING   ; output file\n\n");
 	printf("  [YCSB]:\n");
@@ -100,6 +102,10 @@ void parser(int argc, char * argv[]) {
 				g_ts_batch_alloc = atoi( &argv[i][3] );
 			else if (argv[i][2] == 'u')
 				g_ts_batch_num = atoi( &argv[i][3] );
+			else if (argv[i][2] == 'e')
+				g_bs_epoch = atol( &argv[i][3] );
+			else if (argv[i][2] == 'p')
+				g_prefetch_depth = atoi( &argv[i][3] );
 		} else if (argv[i][1] == 'T') {
 			if (argv[i][2] == 'p')
 				g_perc_payment = atof( &argv[i][3] );
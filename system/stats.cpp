@@ -1,5 +1,6 @@
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include "global.h"
 #include "helper.h"
 #include "stats.h"
@@ -13,10 +14,17 @@ void Stats_thd::init(uint64_t thd_id) {
       _mm_malloc(sizeof(uint64_t) * MAX_TXN_PER_PART, 64);
   all_debug2 = (uint64_t *)
       _mm_malloc(sizeof(uint64_t) * MAX_TXN_PER_PART, 64);
+#if PF_ABORT_GRAPH
+  abort_edges = (AbortEdge *)
+      _mm_malloc(sizeof(AbortEdge) * PF_ABORT_GRAPH_SIZE, 64);
+#endif
 }
 
 void Stats_thd::clear() {
   ALL_METRICS(INIT_VAR, INIT_VAR, INIT_VAR)
+#if PF_ABORT_GRAPH
+  abort_edge_cnt = 0;
+#endif
 }
 
 void Stats_tmp::init() {
@@ -98,6 +106,10 @@ void Stats::print(uint64_t _time) {
   total_latency = total_latency / total_txn_cnt;
   total_commit_latency = total_commit_latency / total_txn_cnt;
   total_time_man = total_time_man - total_time_wait;
+  // the deadlock detectors count per thread
+  cycle_detect += total_dl_detect_cnt;
+  deadlock += total_dl_deadlock_cnt;
+  dl_detect_time += total_time_dl_detect;
   if (output_file != NULL) {
     ofstream outf(output_file);
     if (outf.is_open()) {
@@ -123,8 +135,109 @@ void Stats::print(uint64_t _time) {
   printf("[summary!] mtxns=%.4f, txn_cnt=%lu, abort_cnt=%lu, arate=%.4f\n",
           total_txn_cnt *1e3 / _time , total_txn_cnt, total_abort_cnt,
           (double)total_abort_cnt / (total_txn_cnt + total_abort_cnt));
+#if CC_ALG == DL_DETECT
+  if (cycle_detect > 0)
+    printf("[summary!] cycle_detect=%lu, deadlock_cnt=%lu, dl_detect_time=%.4f, detect_per_call_us=%.4f\n",
+           cycle_detect, deadlock, dl_detect_time / BILLION,
+           dl_detect_time / 1000.0 / cycle_detect);
+#endif
+#if CC_ALG == QCC
+  if (total_qcc_spec_checks > 0)
+    printf("[summary!] spec_runs=%lu, spec_wasted=%lu, snapshot_hit_rate=%.4f\n",
+           total_qcc_spec_runs, total_qcc_spec_wasted,
+           (double) total_qcc_spec_hits / total_qcc_spec_checks);
+  if (g_part_cnt > 1)
+    printf("[summary!] part_cnt=%u, mp_txn_cnt=%lu, mp_rate=%.4f\n",
+           g_part_cnt, total_qcc_mp_cnt,
+           (double) total_qcc_mp_cnt / (total_txn_cnt + total_abort_cnt));
+#endif
+#if CC_ALG == QCC || CC_ALG == ORDERED_LOCK || CC_ALG == BASIC_SCHED
+  // resolving the rw set before the txn is queued, locked or scheduled
+  if (total_time_prepare > 0)
+    printf("[summary!] time_prepare=%.4f, prepare_per_txn_us=%.4f\n",
+           total_time_prepare / BILLION,
+           total_time_prepare / 1000.0 / (total_txn_cnt + total_abort_cnt));
+#endif
+#if TPCC_MGL
+  printf("[summary!] mgl x=%lu, ix=%lu, abort=%lu, row_locks_skipped=%lu\n",
+         total_mgl_x_cnt, total_mgl_ix_cnt, total_mgl_abort_cnt,
+         total_mgl_skip_cnt);
+#endif
+#if WAIT_STRATEGY != WAIT_SPIN
+  printf("[summary!] wait_cnt=%lu, wait_sleep_cnt=%lu\n", total_wait_cnt,
+         total_wait_sleep_cnt);
+#endif
+#if CC_ALG == BAMBOO
+  // waiters already queued on the row when a lock request has to wait
+  if (total_waiter_insert_cnt > 0)
+    printf("[summary!] avg_waiter_len=%.4f, waiter_insert_cnt=%lu\n",
+           (double) total_waiter_len / total_waiter_insert_cnt,
+           total_waiter_insert_cnt);
+#endif
+#if PF_ABORT_GRAPH
+  print_abort_graph();
+#endif
 }
 
+#if PF_ABORT_GRAPH
+void Stats::add_abort_edge(uint64_t thd_id, uint64_t wounder, uint64_t victim,
+                           uint64_t key, const char * table, uint64_t depth) {
+  if (!STATS_ENABLE)
+    return;
+  Stats_thd * s = _stats[thd_id];
+  AbortEdge * e = &s->abort_edges[s->abort_edge_cnt % PF_ABORT_GRAPH_SIZE];
+  e->wounder = wounder;
+  e->victim = victim;
+  e->key = key;
+  e->table = table;
+  e->depth = depth;
+  s->abort_edge_cnt++;
+}
+
+// depth histogram per table, depths >= 15 share the last bucket
+#define AG_DEPTH_BUCKETS 16
+
+void Stats::print_abort_graph() {
+  if (!STATS_ENABLE)
+    return;
+  std::map<std::string, std::vector<uint64_t> > depths;
+  std::map<std::pair<std::string, uint64_t>, uint64_t> keys;
+  uint64_t total_edges = 0;
+  for (uint64_t tid = 0; tid < g_thread_cnt; tid ++) {
+    Stats_thd * s = _stats[tid];
+    uint64_t cnt = min(s->abort_edge_cnt, (uint64_t) PF_ABORT_GRAPH_SIZE);
+    total_edges += s->abort_edge_cnt;
+    for (uint64_t i = 0; i < cnt; i++) {
+      AbortEdge * e = &s->abort_edges[i];
+      std::vector<uint64_t> & hist = depths[e->table];
+      if (hist.empty())
+        hist.resize(AG_DEPTH_BUCKETS, 0);
+      hist[min(e->depth, (uint64_t) AG_DEPTH_BUCKETS - 1)]++;
+      keys[std::make_pair(std::string(e->table), e->key)]++;
+    }
+  }
+  printf("[summary!] abort_graph edges=%lu, kept=%lu\n", total_edges,
+         min(total_edges, (uint64_t) PF_ABORT_GRAPH_SIZE * g_thread_cnt));
+  for (auto it = depths.begin(); it != depths.end(); it++) {
+    printf("[summary!] abort_graph table=%s depth:", it->first.c_str());
+    for (uint64_t d = 0; d < AG_DEPTH_BUCKETS; d++)
+      if (it->second[d])
+        printf(" %lu=%lu", d, it->second[d]);
+    printf("\n");
+  }
+  std::vector<std::pair<uint64_t, std::pair<std::string, uint64_t> > > hot;
+  for (auto it = keys.begin(); it != keys.end(); it++)
+    hot.push_back(std::make_pair(it->second, it->first));
+  uint64_t k = min((uint64_t) PF_ABORT_GRAPH_TOPK, (uint64_t) hot.size());
+  std::partial_sort(hot.begin(), hot.begin() + k, hot.end(),
+      std::greater<std::pair<uint64_t, std::pair<std::string, uint64_t> > >());
+  for (uint64_t i = 0; i < k; i++)
+    printf("[summary!] abort_graph hot_key %lu: table=%s key=%lu edges=%lu\n",
+           i + 1, hot[i].second.first.c_str(), hot[i].second.second,
+           hot[i].first);
+}
+#endif
+
 void Stats::print_lat_distr() {
   FILE * outf;
   if (output_file != NULL) {
@@ -5,14 +5,24 @@
 #define ALL_METRICS(x, y, z) \
   y(uint64_t, txn_cnt) y(uint64_t, abort_cnt) y(uint64_t, user_abort_cnt) \
   x(double, run_time) x(double, time_abort) x(double, time_cleanup) \
-  x(double, time_query) x(double, time_get_latch) x(double, time_get_cs) \
-  x(double, time_copy) x(double, time_retire_latch) x(double, time_retire_cs) \
+  x(double, time_query) x(double, time_prepare) x(double, time_get_latch) x(double, time_get_cs) \
+  x(double, time_copy) x(double, time_copy_get) x(double, time_copy_undo) \
+  x(double, time_retire_latch) x(double, time_retire_cs) \
   x(double, time_release_latch) x(double, time_release_cs) x(double, time_semaphore_cs) \
   x(double, time_commit) y(uint64_t, time_ts_alloc) y(uint64_t, wait_cnt) \
+  y(uint64_t, wait_sleep_cnt) \
+  y(uint64_t, mgl_x_cnt) y(uint64_t, mgl_ix_cnt) y(uint64_t, mgl_abort_cnt) \
+  y(uint64_t, mgl_skip_cnt) \
+  y(uint64_t, qcc_spec_runs) y(uint64_t, qcc_spec_wasted) \
+  y(uint64_t, qcc_spec_checks) y(uint64_t, qcc_spec_hits) \
+  y(uint64_t, qcc_mp_cnt) \
+  y(uint64_t, dl_detect_cnt) y(uint64_t, dl_deadlock_cnt) x(double, time_dl_detect) \
   y(uint64_t, latency) y(uint64_t, commit_latency) y(uint64_t, abort_length) \
   y(uint64_t, cascading_abort_times) z(uint64_t, max_abort_length) \
   y(uint64_t, txn_cnt_long) y(uint64_t, abort_cnt_long) y(uint64_t, cascading_abort_cnt) \
   y(uint64_t, lock_acquire_cnt) y(uint64_t, lock_directly_cnt) \
+  y(uint64_t, barrier_cas_retry) \
+  y(uint64_t, waiter_len) y(uint64_t, waiter_insert_cnt) \
   TMP_METRICS(x, y)
 #define DECLARE_VAR(tpe, name) tpe name;
 #define INIT_VAR(tpe, name) name = 0;
@@ -33,6 +43,18 @@
 #define WRITE_STAT_Y(tpe, name) \
   outf << STR_X(tpe, name) << "= " << VAL_Y(tpe, name) << ", ";
 
+#if PF_ABORT_GRAPH
+// wounder aborts victim on row key of table. depth is 0 for a direct wound,
+// and the position behind the aborted writer for a cascading abort.
+struct AbortEdge {
+  uint64_t wounder;
+  uint64_t victim;
+  uint64_t key;
+  const char * table;
+  uint64_t depth;
+};
+#endif
+
 class Stats_thd {
  public:
   void init(uint64_t thd_id);
@@ -42,6 +64,11 @@ class Stats_thd {
   ALL_METRICS(DECLARE_VAR, DECLARE_VAR, DECLARE_VAR)
   uint64_t * all_debug1;
   uint64_t * all_debug2;
+#if PF_ABORT_GRAPH
+  // ring buffer, the latest PF_ABORT_GRAPH_SIZE edges are kept
+  AbortEdge * abort_edges;
+  uint64_t abort_edge_cnt;
+#endif
   char _pad[CL_SIZE];
 };
 
@@ -77,6 +104,11 @@ class Stats {
   void abort(uint64_t thd_id);
   void print(uint64_t _time);
   void print_lat_distr();
+#if PF_ABORT_GRAPH
+  void add_abort_edge(uint64_t thd_id, uint64_t wounder, uint64_t victim,
+                      uint64_t key, const char * table, uint64_t depth);
+  void print_abort_graph();
+#endif
 };
 
 // From Cicada / MICA
@@ -13,6 +13,10 @@
 #include "mem_alloc.h"
 #include "test.h"
 
+// an aborted txn retries with its ts, see WW_STARV_FREE
+#define TS_RETAIN (CC_ALG == WAIT_DIE || (WW_STARV_FREE && \
+	(CC_ALG == WOUND_WAIT || CC_ALG == BAMBOO)))
+
 void thread_t::init(uint64_t thd_id, workload * workload) {
 	_thd_id = thd_id;
 	_wl = workload;
@@ -44,13 +48,14 @@ RC thread_t::run() {
 
 
 #if CC_ALG == BASIC_SCHED
-	set_affinity(get_thd_id()+1);
+	set_affinity(get_thd_id()+BASIC_SCHED_THREADS);
 #else
 	set_affinity(get_thd_id());
 #endif
 
 #if CC_ALG == QCC
-    qcc_ready(_wl->q, get_thd_id());
+    for (UInt32 p = 0; p < g_part_cnt; p++)
+        qcc_ready(_wl->q[p], get_thd_id());
 #endif
 
 	myrand rdm;
@@ -83,6 +88,10 @@ RC thread_t::run() {
 								m_query = _abort_buffer[i].query;
                                 m_query->rerun = true;
 								txn_starttime = _abort_buffer[i].starttime;
+#if TS_RETAIN
+								// not necessarily the txn that aborted last
+								m_txn->set_ts(_abort_buffer[i].ts);
+#endif
 								_abort_buffer[i].query = NULL;
 								_abort_buffer_empty_slots ++;
 								break;
@@ -100,8 +109,9 @@ RC thread_t::run() {
                         m_txn->abort_cnt = 0;
 						assert(m_query);
                         txn_starttime = starttime;
-#if CC_ALG == WAIT_DIE || (CC_ALG == WOUND_WAIT && WW_STARV_FREE)
-						m_txn->set_ts(get_next_ts());
+#if TS_RETAIN
+						// BAMBOO assigns it on the first conflict or lock
+						m_txn->set_ts(CC_ALG == BAMBOO? 0 : get_next_ts());
 #endif
 					}
 					if (m_query)
@@ -114,10 +124,11 @@ RC thread_t::run() {
 		            m_txn->abort_cnt = 0;
 					assert(m_query);
                     txn_starttime = starttime;
-#if CC_ALG == WAIT_DIE || (CC_ALG == WOUND_WAIT && WW_STARV_FREE)
-					m_txn->set_ts(get_next_ts());
+#if TS_RETAIN
+					m_txn->set_ts(CC_ALG == BAMBOO? 0 : get_next_ts());
 #endif
-                }
+                } else if (rc == Abort)
+                    m_query->rerun = true;
 			}
 		}
 		//INC_STATS(_thd_id, time_query, get_server_clock() - starttime);
@@ -125,17 +136,24 @@ RC thread_t::run() {
 //		_wl->get_txn_man(m_txn, this);
 //#endif
 
-#if (CC_ALG == WOUND_WAIT) && !WW_STARV_FREE
-		m_txn->set_ts(get_next_ts());
-#elif (CC_ALG == BAMBOO)
-		m_txn->set_ts(0);
-#elif CC_ALG == WAIT_DIE || (CC_ALG == WOUND_WAIT && WW_STARV_FREE)
+#if TS_RETAIN
+#if CC_ALG != BAMBOO
         // used for after warmup, since aborted txn keeps original ts
         if (unlikely(m_txn->get_ts() == 0))
             m_txn->set_ts(get_next_ts());
+#endif
+#elif CC_ALG == WOUND_WAIT
+		m_txn->set_ts(get_next_ts());
+#elif CC_ALG == BAMBOO
+		m_txn->set_ts(0);
 #endif
 		m_txn->set_txn_id(get_thd_id() + thd_txn_id * g_thread_cnt);
 		thd_txn_id ++;
+#if CC_ALG == DL_DETECT
+		// victim selection by age
+		m_txn->first_starttime = txn_starttime;
+		m_txn->attempt_starttime = starttime;
+#endif
 
 		if ((CC_ALG == HSTORE && !HSTORE_LOCAL_TS)
 			|| CC_ALG == MVCC
@@ -199,6 +217,7 @@ RC thread_t::run() {
 						_abort_buffer[i].query = m_query;
 						_abort_buffer[i].ready_time = get_server_clock() + penalty;
                         _abort_buffer[i].starttime = txn_starttime;
+                        _abort_buffer[i].ts = m_txn->get_ts();
 						_abort_buffer_empty_slots --;
 						break;
 					}
@@ -216,7 +235,8 @@ RC thread_t::run() {
 #if WORKLOAD == YCSB
             if (unlikely(g_long_txn_ratio > 0)) {
                 if ( ((ycsb_query *) m_query)->request_cnt > REQ_PER_QUERY) {
-                    //INC_STATS(get_thd_id(), txn_cnt_long, 1);
+                    INC_STATS(get_thd_id(), txn_cnt_long, 1);
+                    txn_commit_latency_long.update((endtime - m_query->first_run_time) / 1000);
                 }
             }
 #endif
@@ -255,14 +275,16 @@ RC thread_t::run() {
 #if CC_ALG == IC3
 		    m_txn->set_txn_id(get_thd_id() + thd_txn_id * g_thread_cnt);
 #elif CC_ALG == QCC
-            qcc_finish(_wl->q, this->get_thd_id());
+            for (UInt32 p = 0; p < g_part_cnt; p++)
+                qcc_finish(_wl->q[p], this->get_thd_id());
 #endif
 			return rc;
 		}
 		if (!warmup_finish && txn_cnt >= WARMUP / g_thread_cnt)
 		{
 #if CC_ALG == QCC
-            qcc_finish(_wl->q, this->get_thd_id());
+            for (UInt32 p = 0; p < g_part_cnt; p++)
+                qcc_finish(_wl->q[p], this->get_thd_id());
 #endif
 			stats.clear( get_thd_id() );
 			return FINISH;
@@ -286,7 +308,8 @@ RC thread_t::run() {
 #if CC_ALG == IC3
 		    m_txn->set_txn_id(get_thd_id() + thd_txn_id * g_thread_cnt);
 #elif CC_ALG == QCC
-            qcc_finish(_wl->q, this->get_thd_id());
+            for (UInt32 p = 0; p < g_part_cnt; p++)
+                qcc_finish(_wl->q[p], this->get_thd_id());
 #endif
 			return FINISH;
 		}
@@ -29,6 +29,8 @@ class thread_t {
     ts_t 		get_next_n_ts(int n);
 
     Stat_latency txn_commit_latency;
+    // [YCSB] the long txns only (LONG_TXN_RATIO)
+    Stat_latency txn_commit_latency_long;
 
   private:
     uint64_t 	_host_cid;
@@ -47,6 +49,7 @@ class thread_t {
         ts_t ready_time;
         base_query * query;
         ts_t starttime;
+        ts_t ts; // [WW_STARV_FREE] of the first attempt
     };
     AbortBufferEntry * _abort_buffer;
     int _abort_buffer_size;
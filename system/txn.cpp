@@ -13,12 +13,19 @@
 #include "row_lock.h"
 #include "row_bamboo.h"
 #include "row_ol.h"
+#if WAIT_STRATEGY == WAIT_BACKOFF && defined(__WAITPKG__)
+#include <immintrin.h>
+#endif
 
 void txn_man::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
     this->h_thd = h_thd;
     this->h_wl = h_wl;
     lock_ready = false;
     lock_abort = false;
+#if WAIT_STRATEGY == WAIT_FUTEX
+    lock_seq = 0;
+    lock_sleeping = false;
+#endif
     timestamp = 0;
 #if PF_ABORT
     abort_chain = 0;
@@ -30,25 +37,15 @@ void txn_man::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
     //addr_barriers = &(tmp_barriers);
 #endif
     ready_part = 0;
+#if MGL_ENABLE
+    mgl_cnt = 0;
+#endif
     row_cnt = 0;
     wr_cnt = 0;
     insert_cnt = 0;
     // init accesses
     accesses = (Access **) _mm_malloc(sizeof(Access *) * MAX_ROW_PER_TXN, 64);
-
-#if CC_ALG != QCC
-    for (int i = 0; i < MAX_ROW_PER_TXN; i++)
-        accesses[i] = NULL;
-    num_accesses_alloc = 0;
-#else
-    for (int i = 0; i < MAX_ROW_PER_TXN; i++) {
-        Access *access = (Access *) _mm_malloc(sizeof(Access), 64);
-        access->buf = (row_t *) _mm_malloc(sizeof(row_t), 64);
-        access->buf->init(MAX_TUPLE_SIZE);
-        accesses[i] = access;
-    }
-    num_accesses_alloc = MAX_ROW_PER_TXN;
-#endif
+    alloc_accesses();
 
 #if CC_ALG == TICTOC || CC_ALG == SILO
     _pre_abort = (g_params["pre_abort"] == "true");
@@ -78,8 +75,14 @@ void txn_man::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
     memset(&rows[0], 0, sizeof(rows[0]) * MAX_ROW_PER_TXN);
     nr_rows = 0;
     memset(&queues[0], 0, sizeof(queues[0]) * MAX_ROW_PER_TXN);
-    nr_queues = 0;
+    nr_parts = 0;
     memset(&row_buffer[0], 0, sizeof(row_buffer[0]) * MAX_ROW_PER_TXN);
+    redo = (char *) _mm_malloc(QCC_REDO_SIZE, 64);
+    redo_len = 0;
+    for (int i = 0; i < TPCC_ALL; i++) {
+        spec_hit[i] = 1024; // start out speculating as much as allowed
+        spec_txns[i] = 0;
+    }
 #endif
 }
 
@@ -156,6 +159,16 @@ void txn_man::cleanup(RC rc) {
 
     // go through accesses and release
     for (int rid = row_cnt - 1; rid >= 0; rid --) {
+#if MGL_ENABLE
+        if (accesses[rid]->mgl) {
+            // written in place under the group lock, no row lock to release
+            if (accesses[rid]->type == WR && rc == Abort)
+                accesses[rid]->orig_row->copy(accesses[rid]->orig_data);
+            accesses[rid]->mgl = false;
+            accesses[rid]->orig_row = NULL;
+            continue;
+        }
+#endif
 #if (CC_ALG == WOUND_WAIT) || (CC_ALG == BAMBOO)
         if (accesses[rid]->orig_row == NULL) {
             continue;
@@ -164,13 +177,9 @@ void txn_man::cleanup(RC rc) {
         row_t * orig_r = accesses[rid]->orig_row;
         access_t type = accesses[rid]->type;
 #if COMMUTATIVE_OPS
-        if (accesses[rid]->com_op != COM_NONE && (rc != Abort)) {
-      if (accesses[rid]->com_op == COM_INC)
-        orig_r->inc_value(accesses[rid]->com_col, accesses[rid]->com_val);
-      else
-        orig_r->dec_value(accesses[rid]->com_col, accesses[rid]->com_val);
-      accesses[rid]->com_op = COM_NONE;
-    }
+        if (rc != Abort)
+            apply_merge_ops(accesses[rid]);
+        accesses[rid]->com_cnt = 0;
 #endif
         if (type == WR && rc == Abort)
             type = XP;
@@ -225,29 +234,144 @@ void txn_man::cleanup(RC rc) {
     row_cnt = 0;
     wr_cnt = 0;
     insert_cnt = 0;
+#if MGL_ENABLE
+    // only after the rows above are rolled back
+    for (int i = 0; i < mgl_cnt; i++)
+        mgl_held[i]->release(mgl_x[i]);
+    mgl_cnt = 0;
+#endif
 #if CC_ALG == DL_DETECT
     dl_detector.clear_dep(get_txn_id());
 #endif
 
 #if CC_ALG == ORDERED_LOCK
     nr_rows = 0;
+#elif CC_ALG == QCC
+    // applied by qcc_commit already, or thrown away
+    redo_len = 0;
 #endif
 }
 
 
-#if CC_ALG == BAMBOO || CC_ALG == WOUND_WAIT || CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
-inline
-void txn_man::assign_lock_entry(Access * access) {
+#define SLAB_ALIGN(size) (((size) + 63) & ~63UL)
+// every access slot keeps its Access, lock entry and row buffers next to each
+// other in one slab. init runs on the pinned worker thread, so the memset
+// also places the slab on the worker's NUMA node.
+void txn_man::alloc_accesses() {
+    uint64_t entry_size = 0;
+    int nr_bufs = 0;
+#if CC_ALG == BAMBOO
+    entry_size = sizeof(BBLockEntry);
+#elif CC_ALG == WOUND_WAIT || CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
+    entry_size = sizeof(LockEntry);
+#endif
+#if CC_ALG == SILO || CC_ALG == TICTOC || CC_ALG == BAMBOO
+    nr_bufs = 2;
+#elif CC_ALG == IC3 || CC_ALG == WOUND_WAIT || CC_ALG == QCC || \
+    CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
+    nr_bufs = 1;
+#endif
+#if CC_ALG == QCC
+    // the local copy is only a header, written columns go to the redo log
+    uint64_t buf_size = SLAB_ALIGN(sizeof(row_t));
+#else
+    uint64_t buf_size = SLAB_ALIGN(sizeof(row_t)) + SLAB_ALIGN(MAX_TUPLE_SIZE);
+#endif
+    uint64_t slot_size = SLAB_ALIGN(sizeof(Access)) + SLAB_ALIGN(entry_size) +
+        nr_bufs * buf_size;
+    access_slab = (char *) _mm_malloc(slot_size * MAX_ROW_PER_TXN, 64);
+    memset(access_slab, 0, slot_size * MAX_ROW_PER_TXN);
+
+    for (int i = 0; i < MAX_ROW_PER_TXN; i++) {
+        char * p = access_slab + i * slot_size;
+        Access * access = (Access *) p;
+        p += SLAB_ALIGN(sizeof(Access));
 #if CC_ALG == BAMBOO
-    auto lock_entry = (BBLockEntry *) _mm_malloc(sizeof(BBLockEntry), 64);
-    new (lock_entry) BBLockEntry(this, access);
+        access->lock_entry = new (p) BBLockEntry(this, access);
+#elif CC_ALG == WOUND_WAIT || CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
+        access->lock_entry = new (p) LockEntry(this, access);
+#endif
+        p += SLAB_ALIGN(entry_size);
+        row_t * bufs[2] = {NULL, NULL};
+        for (int b = 0; b < nr_bufs; b++) {
+            bufs[b] = (row_t *) p;
+#if CC_ALG != QCC
+            bufs[b]->data = p + SLAB_ALIGN(sizeof(row_t));
+#endif
+            p += buf_size;
+        }
+#if CC_ALG == SILO || CC_ALG == TICTOC || CC_ALG == BAMBOO
+        // data is for local changes, orig_data for validation or rollback
+        access->data = bufs[0];
+        access->orig_data = bufs[1];
+#elif CC_ALG == IC3 || CC_ALG == WOUND_WAIT
+        access->data = bufs[0];
+#elif CC_ALG == QCC
+        access->buf = bufs[0];
+#elif CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
+        access->orig_data = bufs[0];
+#endif
+#if CC_ALG == IC3 && IC3_FIELD_LOCKING
+        access->tids = (ts_t *) _mm_malloc(sizeof(ts_t) * MAX_FIELD_SIZE, 64);
+#endif
+#if COMMUTATIVE_OPS
+        access->com_cnt = 0;
+#endif
+        accesses[i] = access;
+    }
+    num_accesses_alloc = MAX_ROW_PER_TXN;
+}
+
+#if CC_ALG == BAMBOO || CC_ALG == WOUND_WAIT || CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
+// returns once the lock is granted (lock_ready) or the txn is aborted
+void txn_man::wait_lock() {
+#if WAIT_STRATEGY == WAIT_SPIN
+    while (!lock_ready && !lock_abort)
+        PAUSE
+#else
+    for (UInt32 i = 0; i < WAIT_SPIN_CNT; i++) {
+        if (lock_ready || lock_abort)
+            return;
+        PAUSE
+    }
+#if WAIT_STRATEGY == WAIT_FUTEX
+    while (!lock_ready && !lock_abort) {
+        lock_sleeping = true;
+        // either wake_lock() sees lock_sleeping or we see its flag
+        __sync_synchronize();
+        uint32_t seq = lock_seq;
+        if (lock_ready || lock_abort)
+            break;
+        INC_STATS(get_thd_id(), wait_sleep_cnt, 1);
+        futex_wait(&lock_seq, seq, WAIT_FUTEX_TIMEOUT);
+    }
+    lock_sleeping = false;
+#elif WAIT_STRATEGY == WAIT_BACKOFF
+#ifdef __WAITPKG__
+    // lock_ready and lock_abort share a cache line, any store to it wakes us
+    while (!lock_ready && !lock_abort) {
+        _umonitor((void *) &lock_ready);
+        if (lock_ready || lock_abort)
+            break;
+        INC_STATS(get_thd_id(), wait_sleep_cnt, 1);
+        _umwait(0, __rdtsc() + WAIT_BACKOFF_MAX);
+    }
 #else
-    auto lock_entry = (LockEntry *) _mm_malloc(sizeof(LockEntry), 64);
-    new (lock_entry) LockEntry(this, access);
+    UInt32 backoff = 1;
+    while (!lock_ready && !lock_abort) {
+        if (backoff < WAIT_BACKOFF_MAX) {
+            for (UInt32 i = 0; i < backoff; i++)
+                PAUSE
+            backoff <<= 1;
+        } else {
+            // give the core to whoever we are waiting for
+            INC_STATS(get_thd_id(), wait_sleep_cnt, 1);
+            sched_yield();
+        }
+    }
+#endif
+#endif
 #endif
-    access->lock_entry = lock_entry;
-    //lock_entry->txn = this;
-    //lock_entry->access = access;
 }
 #endif
 
@@ -258,59 +382,7 @@ row_t * txn_man::get_row(row_t * row, access_t type) {
     RC rc = RCOK;
 
 
-    if (accesses[row_cnt] == NULL) {
-        assert(CC_ALG != QCC); // QCC won't go into this loop because of pre-allocation
-        assert(row_cnt < MAX_ROW_PER_TXN);
-
-        Access *access = (Access *) _mm_malloc(sizeof(Access), 64);
-
-#if COMMUTATIVE_OPS
-        // init
-    access->com_op = COM_NONE;
-#endif
-
-        accesses[row_cnt] = access;
-
-#if (CC_ALG == SILO || CC_ALG == TICTOC)
-        access->data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-        access->data->init(MAX_TUPLE_SIZE);
-        access->orig_data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-        access->orig_data->init(MAX_TUPLE_SIZE);
-#elif (CC_ALG == IC3)
-        access->data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-    access->data->init(MAX_TUPLE_SIZE);
-    #if IC3_FIELD_LOCKING
-    access->tids = (ts_t *) _mm_malloc(sizeof(ts_t) * MAX_FIELD_SIZE, 64);
-    #else
-    access->tid = 0;
-    #endif
-#elif (CC_ALG == WOUND_WAIT)
-    // allocate lock entry as well
-    assign_lock_entry(access);
-    // for ww and bb, data is a local copy of original row for txn to work on
-    access->data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-    access->data->init(MAX_TUPLE_SIZE);
-#elif (CC_ALG == BAMBOO)
-    // allocate lock entry as well
-    assign_lock_entry(access);
-    // data is for making local changes before added to retired
-    access->data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-    access->data->init(MAX_TUPLE_SIZE);
-    access->data->table = row->get_table();
-    // orig data is for rollback
-    access->orig_data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-    access->orig_data->init(MAX_TUPLE_SIZE);
-    access->orig_data->table = row->get_table();
-#elif (CC_ALG == DL_DETECT || (CC_ALG == NO_WAIT) || (CC_ALG == WAIT_DIE))
-    // allocate lock entry as well
-    assign_lock_entry(access);
-    access->orig_data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-    access->orig_data->init(MAX_TUPLE_SIZE);
-#endif
-
-        num_accesses_alloc++;
-    }
-
+    assert(row_cnt < MAX_ROW_PER_TXN);
 
     //printf("txn-%lu access(%p) row %p at access[%d]\n", txn_id, accesses[row_cnt], row , row_cnt);
 #if (CC_ALG == WOUND_WAIT) || (CC_ALG == BAMBOO)
@@ -378,12 +450,35 @@ row_t * txn_man::get_row(row_t * row, access_t type) {
         accesses[row_cnt]->data->table = row->get_table();
         accesses[row_cnt]->data->copy(row);
 #elif CC_ALG == BAMBOO
+#if PF_CS
+    uint64_t copy_start = get_sys_clock();
+#endif
         // make local copy to work on
     accesses[row_cnt]->data->table = row->get_table();
     accesses[row_cnt]->data->copy(row);
+#if BB_ADAPTIVE_RETIRE
+    // a write to a cold row is never retired, so nobody reads it dirty
+    // and there is nothing to roll back
+    accesses[row_cnt]->retire = row->manager->is_hot();
+#endif
+#if BB_UNDO_LOG
+    // the before image of the written columns is taken at retire
+    accesses[row_cnt]->data->wr_cols = 0;
+    accesses[row_cnt]->orig_data->table = row->get_table();
+#else
+#if BB_ADAPTIVE_RETIRE
+    if (accesses[row_cnt]->retire) {
+#endif
     // make copy to rollback
     accesses[row_cnt]->orig_data->table = row->get_table();
     accesses[row_cnt]->orig_data->copy(row);
+#if BB_ADAPTIVE_RETIRE
+    }
+#endif
+#endif
+#if PF_CS
+    INC_STATS(get_thd_id(), time_copy_get, get_sys_clock() - copy_start);
+#endif
 #elif ROLL_BACK && (CC_ALG == DL_DETECT || CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE)
     accesses[row_cnt]->orig_data->table = row->get_table();
     accesses[row_cnt]->orig_data->copy(row);
@@ -425,6 +520,48 @@ row_t * txn_man::get_row(row_t * row, access_t type) {
 #endif
 }
 
+#if MGL_ENABLE
+// take the group lock of row on first use: X while the group is cold, IX
+// otherwise. under X the row is written in place without its row lock and its
+// before image is kept in orig_data for rollback. returns NULL on abort.
+row_t * txn_man::get_row_mgl(row_t * row, access_t type, MGLock * lock) {
+    int i = 0;
+    while (i < mgl_cnt && mgl_held[i] != lock)
+        i++;
+    if (i == mgl_cnt) {
+        assert(mgl_cnt < MGL_MAX_PER_TXN);
+        if (lock->is_cold() && lock->try_x()) {
+            mgl_x[i] = true;
+            INC_STATS(get_thd_id(), mgl_x_cnt, 1);
+        } else if (lock->get_ix()) {
+            mgl_x[i] = false;
+            INC_STATS(get_thd_id(), mgl_ix_cnt, 1);
+        } else {
+            INC_STATS(get_thd_id(), mgl_abort_cnt, 1);
+            return NULL;
+        }
+        mgl_held[i] = lock;
+        mgl_cnt++;
+    }
+    if (!mgl_x[i])
+        return get_row(row, type);
+
+    assert(row_cnt < MAX_ROW_PER_TXN);
+    INC_STATS(get_thd_id(), mgl_skip_cnt, 1);
+    Access * access = accesses[row_cnt];
+    access->type = type;
+    access->orig_row = row;
+    access->mgl = true;
+    if (type == WR) {
+        access->orig_data->table = row->get_table();
+        access->orig_data->copy(row);
+        wr_cnt++;
+    }
+    row_cnt++;
+    return row;
+}
+#endif
+
 void txn_man::insert_row(row_t * row, table_t * table) {
     if (CC_ALG == HSTORE)
         return;
@@ -532,12 +669,13 @@ RC txn_man::finish(RC rc) {
     // COMPILER_BARRIER
     // ATOM_ADD(commit_barriers, tmp_barriers);
     // ATOM_SUB(commit_barriers, g_thread_cnt << 2);
-    while (!ATOM_CAS(commit_barriers, 0, COMMITED)) {
+    bool late_retire = g_last_retire > 0 && (retire_threshold < row_cnt - 1);
+    while (!try_commit()) {
         if (commit_barriers & ABORTED) {
             rc = Abort;
             break;
         }
-        if (g_last_retire > 0 && (retire_threshold < row_cnt - 1)) {
+        if (late_retire) {
             //times++;
             //if (times >= 10) {
                 uint64_t lapse = get_server_clock();
@@ -546,9 +684,10 @@ RC txn_man::finish(RC rc) {
                     for (int rid = row_cnt - 1; rid > retire_threshold; rid--) {
                         if (accesses[rid]->lock_entry->type == LOCK_SH)
                             continue;
-                        accesses[rid]->orig_row->retire_row(accesses[rid]->lock_entry);
+                        retire_row(rid);
                     }
                     retire_threshold = row_cnt - 1;
+                    late_retire = false;
                 }
             //if ( (double)(lapse-starttime)/(lapse - start_ts) > 0)
             //    printf("%.6f\n", (lapse - starttime) / (lapse - start_ts));
@@ -579,18 +718,11 @@ RC txn_man::finish(RC rc) {
 
 void
 txn_man::release() {
-    for (int i = 0; i < num_accesses_alloc; i++) {
-    #if CC_ALG == BAMOO || CC_ALG == NO_WAIT || CC_ALG == WOUND_WAIT || CC_ALG == WAIT_DIE || CC_ALG == DL_DETEC
-        delete accesses[i]->lock_entry;
-    #endif
-#if CC_ALG != QCC
-        mem_allocator.free(accesses[i], 0);
-#else
-        // free the buf then the access
-        accesses[i]->buf->free_row();
-        free(accesses[i]);
+#if CC_ALG == IC3 && IC3_FIELD_LOCKING
+    for (int i = 0; i < num_accesses_alloc; i++)
+        _mm_free(accesses[i]->tids);
 #endif
-    }
+    _mm_free(access_slab);
     mem_allocator.free(accesses, 0);
 #if LATCH == LH_MCSLOCK
     delete mcs_node;
@@ -598,58 +730,120 @@ txn_man::release() {
 }
 
 #if COMMUTATIVE_OPS
-void txn_man::inc_value(int col, uint64_t val) {
+void txn_man::merge_value(int col, com_t op, int64_t val) {
   // store operation and execute at commit time
   Access * access = accesses[row_cnt-1];
-  access->com_op = COM_INC;
-  access->com_val = val;
-  access->com_col = col;
+  data_t type = access->orig_row->get_schema()->get_field_dtype(col);
+  assert(type != DT_OTHER && access->com_cnt < COM_OPS_PER_ACCESS);
+  assert(op != COM_CNT || (type != DT_DOUBLE && val >= 0));
+  uint64_t bits = (uint64_t) val;
+  if (type == DT_DOUBLE) {
+    double d = (double) val;
+    memcpy(&bits, &d, sizeof(double));
+  }
+  access->com_ops[access->com_cnt].col = col;
+  access->com_ops[access->com_cnt].op = op;
+  access->com_ops[access->com_cnt].val = bits;
+  access->com_cnt++;
 }
 
-void txn_man::dec_value(int col, uint64_t val) {
-  // store operation and execute at commit time
+void txn_man::merge_value(int col, com_t op, double val) {
   Access * access = accesses[row_cnt-1];
-  access->com_op = COM_DEC;
-  access->com_val = val;
-  access->com_col = col;
+  if (access->orig_row->get_schema()->get_field_dtype(col) != DT_DOUBLE) {
+    merge_value(col, op, (int64_t) val);
+    return;
+  }
+  assert(op != COM_CNT && access->com_cnt < COM_OPS_PER_ACCESS);
+  uint64_t bits;
+  memcpy(&bits, &val, sizeof(double));
+  access->com_ops[access->com_cnt].col = col;
+  access->com_ops[access->com_cnt].op = op;
+  access->com_ops[access->com_cnt].val = bits;
+  access->com_cnt++;
+}
+
+void txn_man::apply_merge_ops(Access * access) {
+  for (int i = 0; i < access->com_cnt; i++)
+    access->orig_row->merge_value(access->com_ops[i].col, access->com_ops[i].op,
+                                  access->com_ops[i].val);
+  access->com_cnt = 0;
 }
 #endif
 
-#if CC_ALG == ORDERED_LOCK
-static int ol_compare_rows(const void *or1, const void *or2)
-{
-    typedef struct {itemid_t *row_item; access_t type;} cmp_type;
+#if INDEX_PIPELINE
+// The accesses are made in query order. With g_prefetch_depth = K, the index
+// entry of access i + K is resolved and its row header prefetched when
+// access i is made. The lock and the data of access i + K/2 are prefetched
+// from that header, which should have arrived by then.
+void txn_man::pf_push(itemid_t * item) {
+    pf_items[pf_cnt++] = item;
+    __builtin_prefetch(item->location, 0);
+}
 
-    const cmp_type *const r1 = (const cmp_type *const)or1;
-    const cmp_type *const r2 = (const cmp_type *const)or2;
-    const uint64_t rank1 = ((row_t *)(r1->row_item->location))->manager->rank;
-    const uint64_t rank2 = ((row_t *)(r2->row_item->location))->manager->rank;
-    if (rank1 == rank2) {
-        printf("fatal: two rows cannot have the same rank\n");
-        fflush(stdout);
-        exit(1);
+itemid_t * txn_man::pf_get(uint32_t i) {
+    uint32_t next = i + (g_prefetch_depth + 1) / 2;
+    if (next < pf_cnt) {
+        row_t * row = (row_t *) pf_items[next]->location;
+        __builtin_prefetch(row->manager, 1);
+        __builtin_prefetch(row->data, 0);
     }
-    if (rank1 < rank2) {
-        return -1;
+    return pf_items[i];
+}
+#endif
+
+#if CC_ALG == ORDERED_LOCK
+// Locks rows[] in rank order. The ranks are plain keys, so the sort does not
+// touch any row. Then the row headers and the locks are prefetched a pass
+// ahead of their use, so the misses overlap instead of stalling every lock.
+void txn_man::ol_lock_rows() {
+    // insertion sort, there are at most MAX_ROW_PER_TXN rows and often
+    // they come mostly in order
+    for (u64 i = 1; i < nr_rows; i++) {
+        const auto row = rows[i];
+        u64 j = i;
+        while (j > 0 && rows[j - 1].rank > row.rank) {
+            rows[j] = rows[j - 1];
+            j--;
+        }
+        rows[j] = row;
+        if (j > 0 && rows[j - 1].rank == row.rank) {
+            printf("fatal: two rows cannot have the same rank\n");
+            fflush(stdout);
+            exit(1);
+        }
+    }
+    for (u64 i = 0; i < nr_rows; i++)
+        __builtin_prefetch(rows[i].row_item->location, 0);
+    for (u64 i = 0; i < nr_rows; i++) {
+        rows[i].lock = ((row_t *)rows[i].row_item->location)->manager;
+        __builtin_prefetch(rows[i].lock, 1);
+    }
+    for (u64 i = 0; i < nr_rows; i++) {
+        // lock, or wait
+        rows[i].lock->lock(rows[i].type);
     }
-    return 1;
 }
 
-void txn_man::ol_sort_rows() {
-    qsort((void *)rows, nr_rows, sizeof(rows[0]), ol_compare_rows);
+void txn_man::ol_unlock_rows() {
+    for (u64 i = nr_rows; i > 0; i--)
+        rows[i - 1].lock->unlock(rows[i - 1].type);
+    nr_rows = 0;
 }
 #endif
 
 #if CC_ALG == BASIC_SCHED
 static int bs_compare_requests(const void *or1, const void *or2) {
-    typedef struct {u64 id; access_t type;} cmp_type;
+    typedef struct {u64 id; u64 hash; access_t type;} cmp_type;
     const cmp_type *const r1 = (const cmp_type *const)or1;
     const cmp_type *const r2 = (const cmp_type *const)or2;
-    const u64 id1 = r1->id;
-    const u64 id2 = r2->id;
-    if (id1 < id2) {
+    // by hash so that the parts of each scheduler shard are contiguous and
+    // in shard order, then by id to break collisions
+    if (r1->hash != r2->hash) {
+        return (r1->hash < r2->hash) ? -1 : 1;
+    }
+    if (r1->id < r2->id) {
         return -1;
-    } else if (id1 > id2) {
+    } else if (r1->id > r2->id) {
         return 1;
     }
     return 0;
@@ -659,7 +853,7 @@ void txn_man::bs_regulate_request() {
     // sort first
     const u64 nr_requests = request.nr_requests;
     for (u64 i=0; i<nr_requests; i++) {
-        request.requests[i].id = request.requests[i].id % BASIC_SCHED_SIZE;
+        request.requests[i].hash = basic_sched_hash(request.requests[i].id);
     }
     qsort((void *)&request.requests, nr_requests, sizeof(request.requests[0]), bs_compare_requests);
 
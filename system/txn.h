@@ -1,6 +1,7 @@
 #pragma once
 
 #include "global.h"
+#include "mgl.h"
 
 #if CC_ALG == BASIC_SCHED
 #include "basic_sched.h"
@@ -17,8 +18,14 @@ class txn_man;
 struct LockEntry;
 #elif CC_ALG == BAMBOO
 struct BBLockEntry;
+#elif CC_ALG == ORDERED_LOCK
+class Row_ol;
 #endif
 
+// [PREFETCH_DEPTH] the algs that lock each row when it is accessed
+#define INDEX_PIPELINE (CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE || \
+    CC_ALG == DL_DETECT || CC_ALG == WOUND_WAIT || CC_ALG == BAMBOO)
+
 // each thread has a txn_man.
 // a txn_man corresponds to a single transaction.
 
@@ -33,6 +40,9 @@ class Access {
     row_t * 	orig_data;
 #if CC_ALG == BAMBOO
     BBLockEntry * lock_entry;
+  #if BB_ADAPTIVE_RETIRE
+    bool      retire; // decided at get_row from the row's contention
+  #endif
 #elif CC_ALG == WOUND_WAIT || CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
     LockEntry * lock_entry;
 #elif CC_ALG == TICTOC
@@ -53,11 +63,17 @@ class Access {
 #elif CC_ALG == QCC
     row_t     *buf;
 #endif
+#if MGL_ENABLE
+    bool      mgl; // covered by a group lock held in X, no row lock taken
+#endif
 #if COMMUTATIVE_OPS
-    // support increment-only for now
-    uint64_t  com_val;
-    int       com_col;
-    com_t     com_op;
+    // merge ops on orig_row, applied at commit
+    struct {
+        int       col;
+        com_t     op;
+        uint64_t  val; // in the column's type
+    } com_ops[COM_OPS_PER_ACCESS];
+    int       com_cnt;
 #endif
     void cleanup();
 };
@@ -103,12 +119,21 @@ class txn_man
     bool volatile       lock_ready;
     bool volatile       lock_abort; // forces another waiting txn to abort.
     status_t volatile   status; // RUNNING, COMMITED, ABORTED, HOLDING
+#if WAIT_STRATEGY == WAIT_FUTEX
+    // futex word bumped whenever lock_ready/lock_abort is set
+    uint32_t volatile   lock_seq;
+    bool volatile       lock_sleeping;
+#define WAIT_WORD_SIZE  (sizeof(uint32_t) + sizeof(bool))
+#else
+#define WAIT_WORD_SIZE  0
+#endif
 #if PF_ABORT
     uint64_t            abort_chain;
     uint8_t             padding0[64 - sizeof(bool)*2 - sizeof(status_t)-
-    sizeof(uint64_t)];
+    sizeof(uint64_t) - WAIT_WORD_SIZE];
 #else
-    uint8_t             padding0[64 - sizeof(bool)*2 - sizeof(status_t)];
+    uint8_t             padding0[64 - sizeof(bool)*2 - sizeof(status_t) -
+    WAIT_WORD_SIZE];
 #endif
     // ideal second cache line
 
@@ -132,6 +157,10 @@ class txn_man
     int	 		        wr_cnt;
     Access **		    accesses;
     int 			    num_accesses_alloc;
+    char *              access_slab; // backs accesses[], see alloc_accesses()
+    // [DL_DETECT] victim selection by age
+    ts_t                first_starttime; // kept across restarts
+    ts_t                attempt_starttime;
     // [TIMESTAMP, MVCC]
     bool volatile       ts_ready;
     // [HSTORE]
@@ -164,18 +193,37 @@ class txn_man
     volatile void * volatile     history_entry;
 #elif CC_ALG == ORDERED_LOCK
     struct {
-        itemid_t *row_item; // (row_t *)row_item->location->manager is Row_ol
+        u64 rank; // OL_RANK(table, key), known before any row is touched
+        itemid_t *row_item;
+        Row_ol *lock; // (row_t *)row_item->location->manager, set by ol_lock_rows
         access_t type;
     } rows[MAX_ROW_PER_TXN];
     u64 nr_rows;
+    itemid_t *row_buffer[MAX_ROW_PER_TXN]; // rows in query order
 #elif CC_ALG == BASIC_SCHED
     struct basic_sched_request request;
+    itemid_t *row_buffer[MAX_ROW_PER_TXN];
 #elif CC_ALG == QCC
     struct qcc_rvec rows[MAX_ROW_PER_TXN];
+    u64 row_part[MAX_ROW_PER_TXN]; // partition of rows[i]
     u64 nr_rows;
     struct qcc_qvec queues[MAX_ROW_PER_TXN];
-    u32 nr_queues;
     itemid_t *row_buffer[MAX_ROW_PER_TXN];
+    // one qcc txn per partition touched, rows[] is grouped by partition
+    struct {
+        struct qcc *q;
+        struct qcc_txn *txn;
+        u32 row_start; // its rows and queues start here
+        u32 nr_rows;
+        u32 nr_queues;
+    } parts[MAX_ROW_PER_TXN];
+    u32 nr_parts;
+    // ewma (x1024) of the speculative runs that were used, and txn count
+    u32 spec_hit[TPCC_ALL];
+    u64 spec_txns[TPCC_ALL];
+    // columns written by the txn, see qcc_redo_col
+    char *redo;
+    u64 redo_len;
 #endif
 
     // **************************************
@@ -205,10 +253,42 @@ class txn_man
     // Individual Helper Functions
     // **************************************
 
+    // [DL_DETECT, NO_WAIT, WAIT_DIE, WOUND_WAIT, BAMBOO]
+    void                wait_lock();
+    // used by other threads to grant the lock or abort the waiting txn
+    inline void         set_lock_ready() { lock_ready = true; wake_lock(); };
+    inline void         set_lock_abort() { lock_abort = true; wake_lock(); };
+    inline void         wake_lock() {
+#if WAIT_STRATEGY == WAIT_FUTEX
+        // full barrier, pairs with the one in wait_lock()
+        ATOM_ADD(lock_seq, 1);
+        if (lock_sleeping)
+            futex_wake(&lock_seq);
+#endif
+    };
+
+#if MGL_ENABLE
+    // [TPCC_MGL]
+    row_t *             get_row_mgl(row_t * row, access_t type, MGLock * lock);
+    MGLock *            mgl_held[MGL_MAX_PER_TXN];
+    bool                mgl_x[MGL_MAX_PER_TXN];
+    int                 mgl_cnt;
+#endif
+
+#if INDEX_PIPELINE
+    // [PREFETCH_DEPTH] index entries resolved ahead of the accesses
+    void                pf_push(itemid_t * item);
+    itemid_t *          pf_get(uint32_t i);
+    itemid_t *          pf_items[MAX_ROW_PER_TXN];
+    uint32_t            pf_cnt;
+#endif
+
     // [COMMUTATIVE OPERATIONS]
 #if COMMUTATIVE_OPS
-    void                inc_value(int col, uint64_t val);
-    void                dec_value(int col, uint64_t val);
+    // queue a merge op on a column of the last accessed row
+    void                merge_value(int col, com_t op, int64_t val);
+    void                merge_value(int col, com_t op, double val);
+    void                apply_merge_ops(Access * access);
 #endif
     // [WW, BAMBOO]
     // if already abort, no change, return aborted
@@ -223,14 +303,16 @@ class txn_man
         // (1) what if two txns both atomic add? may change from abort to commit
         // (2) moreover, may exceed two bits
         while (s == RUNNING) {
-            ATOM_CAS(commit_barriers, local, (barriers << 2) + ABORTED);
+            // a failure means the word changed since it was read
+            if (!ATOM_CAS(commit_barriers, local, (barriers << 2) + ABORTED))
+                INC_STATS(get_thd_id(), barrier_cas_retry, 1);
             local = commit_barriers;
             barriers = local >> 2;
             s = local & 3UL;
         }
         if (s == ABORTED) {
             if (!lock_abort)
-                lock_abort = true;
+                set_lock_abort();
 #if PF_MODEL
             if (cascading)
                 INC_STATS(get_thd_id(), cascading_abort_cnt, 1);
@@ -244,7 +326,7 @@ class txn_man
         }
 #elif CC_ALG == WOUND_WAIT || CC_ALG == IC3
        if (ATOM_CAS(status, RUNNING, ABORTED)) {
-            lock_abort = true;
+            set_lock_abort();
             return ABORTED;
        }
        return status; // COMMITED or ABORTED
@@ -255,6 +337,8 @@ class txn_man
     status_t            wound_txn(txn_man * txn);
     void                increment_commit_barriers();
     void                decrement_commit_barriers();
+    // set status to COMMITED if no barrier is left
+    bool                try_commit();
     // dynamically set timestamp
     bool                atomic_set_ts(ts_t ts);
     ts_t			    set_next_ts(int n);
@@ -288,8 +372,23 @@ class txn_man
     RC				    validate_silo();
 #elif CC_ALG == QCC
     RC                  qcc_commit();
+    // [QCC] speculation budget, type is the TPCCTxnType (0 for YCSB)
+    u64                 qcc_spec_budget(u32 type, u64 max_try);
+    void                qcc_spec_result(u32 type, u64 runs, bool used);
+    u8                  qcc_spec_consistent();
+    // [QCC] the txn's queues in every partition it touches
+    void                qcc_enqueue();
+    u8                  qcc_try_wait();
+    void                qcc_wait();
+    void                qcc_snapshot();
+    u8                  qcc_snapshot_consistent();
+    void                qcc_announce();
+    // [QCC] redo log
+    char *              qcc_redo_col(row_t *local, int id);
+    char *              qcc_redo_find(row_t *row, u32 pos);
 #elif CC_ALG == ORDERED_LOCK
-    void                ol_sort_rows();
+    void                ol_lock_rows();
+    void                ol_unlock_rows();
 #elif CC_ALG == BASIC_SCHED
     void                bs_regulate_request();
 #endif
@@ -299,9 +398,7 @@ class txn_man
     void                index_insert(row_t * row, INDEX * index, idx_key_t key);
 
   private:
-#if CC_ALG == BAMBOO || CC_ALG == WOUND_WAIT || CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
-    void                assign_lock_entry(Access * access);
-#endif
+    void                alloc_accesses();
 
 };
 
@@ -28,7 +28,7 @@ public:
 	map<string, INDEX *> indexes;
 
 #if CC_ALG == QCC
-        struct qcc *q;
+        struct qcc **q; // one per partition
 #endif
 
 #if CC_ALG == BASIC_SCHED